@@ -23,3 +23,352 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// gridCCDrNative
+List gridCCDrNative(NumericVector cors, List init_betas, NumericVector init_sigmas, unsigned int nn, NumericVector lambdas, NumericVector params, IntegerVector blocks, int verbose);
+RcppExport SEXP Rccdr2_gridCCDrNative(SEXP corsSEXP, SEXP init_betasSEXP, SEXP init_sigmasSEXP, SEXP nnSEXP, SEXP lambdasSEXP, SEXP paramsSEXP, SEXP blocksSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type cors(corsSEXP);
+    Rcpp::traits::input_parameter< List >::type init_betas(init_betasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type init_sigmas(init_sigmasSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type nn(nnSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type lambdas(lambdasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type params(paramsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type blocks(blocksSEXP);
+    Rcpp::traits::input_parameter< int >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(gridCCDrNative(cors, init_betas, init_sigmas, nn, lambdas, params, blocks, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
+// gridCCDrFullMatrix
+List gridCCDrFullMatrix(NumericMatrix cors, List init_betas, NumericVector init_sigmas, unsigned int nn, NumericVector lambdas, NumericVector params, IntegerVector blocks, int verbose);
+RcppExport SEXP Rccdr2_gridCCDrFullMatrix(SEXP corsSEXP, SEXP init_betasSEXP, SEXP init_sigmasSEXP, SEXP nnSEXP, SEXP lambdasSEXP, SEXP paramsSEXP, SEXP blocksSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericMatrix >::type cors(corsSEXP);
+    Rcpp::traits::input_parameter< List >::type init_betas(init_betasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type init_sigmas(init_sigmasSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type nn(nnSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type lambdas(lambdasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type params(paramsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type blocks(blocksSEXP);
+    Rcpp::traits::input_parameter< int >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(gridCCDrFullMatrix(cors, init_betas, init_sigmas, nn, lambdas, params, blocks, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
+// gridCCDrEdges
+List gridCCDrEdges(SEXP cors, List init_betas, NumericVector init_sigmas, unsigned int nn, NumericVector lambdas, NumericVector params, IntegerVector blocks, int verbose, std::string format, int base);
+RcppExport SEXP Rccdr2_gridCCDrEdges(SEXP corsSEXP, SEXP init_betasSEXP, SEXP init_sigmasSEXP, SEXP nnSEXP, SEXP lambdasSEXP, SEXP paramsSEXP, SEXP blocksSEXP, SEXP verboseSEXP, SEXP formatSEXP, SEXP baseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type cors(corsSEXP);
+    Rcpp::traits::input_parameter< List >::type init_betas(init_betasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type init_sigmas(init_sigmasSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type nn(nnSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type lambdas(lambdasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type params(paramsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type blocks(blocksSEXP);
+    Rcpp::traits::input_parameter< int >::type verbose(verboseSEXP);
+    Rcpp::traits::input_parameter< std::string >::type format(formatSEXP);
+    Rcpp::traits::input_parameter< int >::type base(baseSEXP);
+    rcpp_result_gen = Rcpp::wrap(gridCCDrEdges(cors, init_betas, init_sigmas, nn, lambdas, params, blocks, verbose, format, base));
+    return rcpp_result_gen;
+END_RCPP
+}
+// gridCCDrReordered
+List gridCCDrReordered(SEXP cors, List init_betas, NumericVector init_sigmas, unsigned int nn, NumericVector lambdas, NumericVector params, IntegerVector blocks, int verbose, std::string format, int base);
+RcppExport SEXP Rccdr2_gridCCDrReordered(SEXP corsSEXP, SEXP init_betasSEXP, SEXP init_sigmasSEXP, SEXP nnSEXP, SEXP lambdasSEXP, SEXP paramsSEXP, SEXP blocksSEXP, SEXP verboseSEXP, SEXP formatSEXP, SEXP baseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type cors(corsSEXP);
+    Rcpp::traits::input_parameter< List >::type init_betas(init_betasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type init_sigmas(init_sigmasSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type nn(nnSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type lambdas(lambdasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type params(paramsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type blocks(blocksSEXP);
+    Rcpp::traits::input_parameter< int >::type verbose(verboseSEXP);
+    Rcpp::traits::input_parameter< std::string >::type format(formatSEXP);
+    Rcpp::traits::input_parameter< int >::type base(baseSEXP);
+    rcpp_result_gen = Rcpp::wrap(gridCCDrReordered(cors, init_betas, init_sigmas, nn, lambdas, params, blocks, verbose, format, base));
+    return rcpp_result_gen;
+END_RCPP
+}
+// gridCCDrLazy
+List gridCCDrLazy(SEXP cors, List init_betas, NumericVector init_sigmas, unsigned int nn, NumericVector lambdas, NumericVector params, IntegerVector blocks, int verbose, int base);
+RcppExport SEXP Rccdr2_gridCCDrLazy(SEXP corsSEXP, SEXP init_betasSEXP, SEXP init_sigmasSEXP, SEXP nnSEXP, SEXP lambdasSEXP, SEXP paramsSEXP, SEXP blocksSEXP, SEXP verboseSEXP, SEXP baseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type cors(corsSEXP);
+    Rcpp::traits::input_parameter< List >::type init_betas(init_betasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type init_sigmas(init_sigmasSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type nn(nnSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type lambdas(lambdasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type params(paramsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type blocks(blocksSEXP);
+    Rcpp::traits::input_parameter< int >::type verbose(verboseSEXP);
+    Rcpp::traits::input_parameter< int >::type base(baseSEXP);
+    rcpp_result_gen = Rcpp::wrap(gridCCDrLazy(cors, init_betas, init_sigmas, nn, lambdas, params, blocks, verbose, base));
+    return rcpp_result_gen;
+END_RCPP
+}
+// screenNeighbourhoods
+IntegerMatrix screenNeighbourhoods(SEXP cors, int pp, double lambda, std::string rule, int threads, IntegerVector order);
+RcppExport SEXP Rccdr2_screenNeighbourhoods(SEXP corsSEXP, SEXP ppSEXP, SEXP lambdaSEXP, SEXP ruleSEXP, SEXP threadsSEXP, SEXP orderSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type cors(corsSEXP);
+    Rcpp::traits::input_parameter< int >::type pp(ppSEXP);
+    Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
+    Rcpp::traits::input_parameter< std::string >::type rule(ruleSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type order(orderSEXP);
+    rcpp_result_gen = Rcpp::wrap(screenNeighbourhoods(cors, pp, lambda, rule, threads, order));
+    return rcpp_result_gen;
+END_RCPP
+}
+// screenMarginal
+IntegerMatrix screenMarginal(SEXP cors, int pp, int k, double threshold, std::string rule, int threads, IntegerVector order);
+RcppExport SEXP Rccdr2_screenMarginal(SEXP corsSEXP, SEXP ppSEXP, SEXP kSEXP, SEXP thresholdSEXP, SEXP ruleSEXP, SEXP threadsSEXP, SEXP orderSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type cors(corsSEXP);
+    Rcpp::traits::input_parameter< int >::type pp(ppSEXP);
+    Rcpp::traits::input_parameter< int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< std::string >::type rule(ruleSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type order(orderSEXP);
+    rcpp_result_gen = Rcpp::wrap(screenMarginal(cors, pp, k, threshold, rule, threads, order));
+    return rcpp_result_gen;
+END_RCPP
+}
+// nodeOrderNative
+IntegerVector nodeOrderNative(SEXP cors, int pp, std::string stat, int threads);
+RcppExport SEXP Rccdr2_nodeOrderNative(SEXP corsSEXP, SEXP ppSEXP, SEXP statSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type cors(corsSEXP);
+    Rcpp::traits::input_parameter< int >::type pp(ppSEXP);
+    Rcpp::traits::input_parameter< std::string >::type stat(statSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(nodeOrderNative(cors, pp, stat, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// allBlocksNative
+IntegerMatrix allBlocksNative(IntegerVector nodes, int threads);
+RcppExport SEXP Rccdr2_allBlocksNative(SEXP nodesSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< IntegerVector >::type nodes(nodesSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(allBlocksNative(nodes, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// gridCCDrComponents
+List gridCCDrComponents(SEXP cors, List init_betas, NumericVector init_sigmas, unsigned int nn, NumericVector lambdas, NumericVector params, IntegerVector blocks, int verbose, std::string format, int base, int threads);
+RcppExport SEXP Rccdr2_gridCCDrComponents(SEXP corsSEXP, SEXP init_betasSEXP, SEXP init_sigmasSEXP, SEXP nnSEXP, SEXP lambdasSEXP, SEXP paramsSEXP, SEXP blocksSEXP, SEXP verboseSEXP, SEXP formatSEXP, SEXP baseSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type cors(corsSEXP);
+    Rcpp::traits::input_parameter< List >::type init_betas(init_betasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type init_sigmas(init_sigmasSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type nn(nnSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type lambdas(lambdasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type params(paramsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type blocks(blocksSEXP);
+    Rcpp::traits::input_parameter< int >::type verbose(verboseSEXP);
+    Rcpp::traits::input_parameter< std::string >::type format(formatSEXP);
+    Rcpp::traits::input_parameter< int >::type base(baseSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(gridCCDrComponents(cors, init_betas, init_sigmas, nn, lambdas, params, blocks, verbose, format, base, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// gridCCDrParallel
+List gridCCDrParallel(SEXP cors, List init_betas, NumericVector init_sigmas, unsigned int nn, NumericVector lambdas, NumericVector params, IntegerVector blocks, int verbose, std::string format, int base, int segments, int threads);
+RcppExport SEXP Rccdr2_gridCCDrParallel(SEXP corsSEXP, SEXP init_betasSEXP, SEXP init_sigmasSEXP, SEXP nnSEXP, SEXP lambdasSEXP, SEXP paramsSEXP, SEXP blocksSEXP, SEXP verboseSEXP, SEXP formatSEXP, SEXP baseSEXP, SEXP segmentsSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type cors(corsSEXP);
+    Rcpp::traits::input_parameter< List >::type init_betas(init_betasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type init_sigmas(init_sigmasSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type nn(nnSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type lambdas(lambdasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type params(paramsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type blocks(blocksSEXP);
+    Rcpp::traits::input_parameter< int >::type verbose(verboseSEXP);
+    Rcpp::traits::input_parameter< std::string >::type format(formatSEXP);
+    Rcpp::traits::input_parameter< int >::type base(baseSEXP);
+    Rcpp::traits::input_parameter< int >::type segments(segmentsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(gridCCDrParallel(cors, init_betas, init_sigmas, nn, lambdas, params, blocks, verbose, format, base, segments, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// gridCCDrEnsemble
+List gridCCDrEnsemble(SEXP cors, List init_betas, NumericVector init_sigmas, unsigned int nn, NumericVector lambdas, NumericVector params, IntegerVector blocks, int verbose, int copies, bool keep_paths, int base, int threads);
+RcppExport SEXP Rccdr2_gridCCDrEnsemble(SEXP corsSEXP, SEXP init_betasSEXP, SEXP init_sigmasSEXP, SEXP nnSEXP, SEXP lambdasSEXP, SEXP paramsSEXP, SEXP blocksSEXP, SEXP verboseSEXP, SEXP copiesSEXP, SEXP keep_pathsSEXP, SEXP baseSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type cors(corsSEXP);
+    Rcpp::traits::input_parameter< List >::type init_betas(init_betasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type init_sigmas(init_sigmasSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type nn(nnSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type lambdas(lambdasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type params(paramsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type blocks(blocksSEXP);
+    Rcpp::traits::input_parameter< int >::type verbose(verboseSEXP);
+    Rcpp::traits::input_parameter< int >::type copies(copiesSEXP);
+    Rcpp::traits::input_parameter< bool >::type keep_paths(keep_pathsSEXP);
+    Rcpp::traits::input_parameter< int >::type base(baseSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(gridCCDrEnsemble(cors, init_betas, init_sigmas, nn, lambdas, params, blocks, verbose, copies, keep_paths, base, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ccdrTargetEdges
+List ccdrTargetEdges(NumericVector cors, List init_betas, NumericVector init_sigmas, unsigned int nn, int target_edges, double max_lambda, double min_lambda, unsigned int max_fits, NumericVector params, IntegerVector blocks, int verbose);
+RcppExport SEXP Rccdr2_ccdrTargetEdges(SEXP corsSEXP, SEXP init_betasSEXP, SEXP init_sigmasSEXP, SEXP nnSEXP, SEXP target_edgesSEXP, SEXP max_lambdaSEXP, SEXP min_lambdaSEXP, SEXP max_fitsSEXP, SEXP paramsSEXP, SEXP blocksSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type cors(corsSEXP);
+    Rcpp::traits::input_parameter< List >::type init_betas(init_betasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type init_sigmas(init_sigmasSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type nn(nnSEXP);
+    Rcpp::traits::input_parameter< int >::type target_edges(target_edgesSEXP);
+    Rcpp::traits::input_parameter< double >::type max_lambda(max_lambdaSEXP);
+    Rcpp::traits::input_parameter< double >::type min_lambda(min_lambdaSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type max_fits(max_fitsSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type params(paramsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type blocks(blocksSEXP);
+    Rcpp::traits::input_parameter< int >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(ccdrTargetEdges(cors, init_betas, init_sigmas, nn, target_edges, max_lambda, min_lambda, max_fits, params, blocks, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
+// getKernelVariant
+std::string getKernelVariant();
+RcppExport SEXP Rccdr2_getKernelVariant() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(getKernelVariant());
+    return rcpp_result_gen;
+END_RCPP
+}
+// getColumnPoolStats
+List getColumnPoolStats();
+RcppExport SEXP Rccdr2_getColumnPoolStats() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(getColumnPoolStats());
+    return rcpp_result_gen;
+END_RCPP
+}
+// setColumnPoolLimit
+double setColumnPoolLimit(double bytes);
+RcppExport SEXP Rccdr2_setColumnPoolLimit(SEXP bytesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< double >::type bytes(bytesSEXP);
+    rcpp_result_gen = Rcpp::wrap(setColumnPoolLimit(bytes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// setThreadCap
+int setThreadCap(int threads);
+RcppExport SEXP Rccdr2_setThreadCap(SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(setThreadCap(threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// getThreadCap
+int getThreadCap();
+RcppExport SEXP Rccdr2_getThreadCap() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(getThreadCap());
+    return rcpp_result_gen;
+END_RCPP
+}
+// gridCCDrCheckpointed
+List gridCCDrCheckpointed(NumericVector cors, List init_betas, NumericVector init_sigmas, unsigned int nn, NumericVector lambdas, NumericVector params, IntegerVector blocks, int verbose, std::string checkpoint_file, unsigned int checkpoint_every);
+RcppExport SEXP Rccdr2_gridCCDrCheckpointed(SEXP corsSEXP, SEXP init_betasSEXP, SEXP init_sigmasSEXP, SEXP nnSEXP, SEXP lambdasSEXP, SEXP paramsSEXP, SEXP blocksSEXP, SEXP verboseSEXP, SEXP checkpoint_fileSEXP, SEXP checkpoint_everySEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type cors(corsSEXP);
+    Rcpp::traits::input_parameter< List >::type init_betas(init_betasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type init_sigmas(init_sigmasSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type nn(nnSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type lambdas(lambdasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type params(paramsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type blocks(blocksSEXP);
+    Rcpp::traits::input_parameter< int >::type verbose(verboseSEXP);
+    Rcpp::traits::input_parameter< std::string >::type checkpoint_file(checkpoint_fileSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type checkpoint_every(checkpoint_everySEXP);
+    rcpp_result_gen = Rcpp::wrap(gridCCDrCheckpointed(cors, init_betas, init_sigmas, nn, lambdas, params, blocks, verbose, checkpoint_file, checkpoint_every));
+    return rcpp_result_gen;
+END_RCPP
+}
+// gridCCDrResume
+List gridCCDrResume(std::string checkpoint_file, NumericVector cors, IntegerVector blocks, int verbose, unsigned int checkpoint_every, unsigned int keep);
+RcppExport SEXP Rccdr2_gridCCDrResume(SEXP checkpoint_fileSEXP, SEXP corsSEXP, SEXP blocksSEXP, SEXP verboseSEXP, SEXP checkpoint_everySEXP, SEXP keepSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type checkpoint_file(checkpoint_fileSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type cors(corsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type blocks(blocksSEXP);
+    Rcpp::traits::input_parameter< int >::type verbose(verboseSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type checkpoint_every(checkpoint_everySEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type keep(keepSEXP);
+    rcpp_result_gen = Rcpp::wrap(gridCCDrResume(checkpoint_file, cors, blocks, verbose, checkpoint_every, keep));
+    return rcpp_result_gen;
+END_RCPP
+}
+// gridCCDrAdaptive
+List gridCCDrAdaptive(NumericVector cors, List init_betas, NumericVector init_sigmas, unsigned int nn, NumericVector lambdas, unsigned int max_fits, int max_edge_jump, double max_objective_jump, NumericVector params, IntegerVector blocks, int verbose);
+RcppExport SEXP Rccdr2_gridCCDrAdaptive(SEXP corsSEXP, SEXP init_betasSEXP, SEXP init_sigmasSEXP, SEXP nnSEXP, SEXP lambdasSEXP, SEXP max_fitsSEXP, SEXP max_edge_jumpSEXP, SEXP max_objective_jumpSEXP, SEXP paramsSEXP, SEXP blocksSEXP, SEXP verboseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type cors(corsSEXP);
+    Rcpp::traits::input_parameter< List >::type init_betas(init_betasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type init_sigmas(init_sigmasSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type nn(nnSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type lambdas(lambdasSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type max_fits(max_fitsSEXP);
+    Rcpp::traits::input_parameter< int >::type max_edge_jump(max_edge_jumpSEXP);
+    Rcpp::traits::input_parameter< double >::type max_objective_jump(max_objective_jumpSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type params(paramsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type blocks(blocksSEXP);
+    Rcpp::traits::input_parameter< int >::type verbose(verboseSEXP);
+    rcpp_result_gen = Rcpp::wrap(gridCCDrAdaptive(cors, init_betas, init_sigmas, nn, lambdas, max_fits, max_edge_jump, max_objective_jump, params, blocks, verbose));
+    return rcpp_result_gen;
+END_RCPP
+}
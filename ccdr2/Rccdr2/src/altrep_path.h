@@ -0,0 +1,270 @@
+//
+//  altrep_path.h
+//  ccdr2
+//
+
+#ifndef altrep_path_h
+#define altrep_path_h
+
+//------------------------------------------------------------------------------/
+//   LAZY (ALTREP) PATHS FOR R
+//------------------------------------------------------------------------------/
+
+//
+// A LazyPath keeps a whole solution path on the C++ side (as a SolutionPath, see SolutionPath.h) and hands R one
+//   set of vectors per estimate, (rows, cols, vals, sigmas), exactly as in the triplet layout of EdgeArrays.h.
+//
+// With R >= 3.6 these vectors are ALTREP objects: they know their length, but their contents are only built
+//   (and cached) when R first touches them, so an R session can hold a long path over many nodes while only
+//   paying for the estimates that are actually looked at. Every vector keeps a reference to the LazyPath (through
+//   an external pointer), and the C++ path is freed once R has garbage collected all of them.
+//
+// With older versions of R the same vectors are built eagerly.
+//
+// NOTES:
+//   -only included by rcpp_wrap.cpp (everything here is defined in the header)
+//   -the classes are registered in R_init_Rccdr2 (see registerLazyPathClasses)
+//
+
+#if defined(R_VERSION)
+    #if R_VERSION >= R_Version(3, 6, 0)
+        #define _CCDR_HAS_ALTREP_
+        #include <R_ext/Altrep.h>
+    #endif
+#endif
+
+struct LazyPath{
+    SolutionPath path;
+    int base;                   // first node index (0 or 1)
+    std::vector<int> nedges;    // number of edges in each estimate, as counted by EdgeArrays
+};
+
+enum lazyField {LAZY_ROWS, LAZY_COLS, LAZY_VALS, LAZY_SIGMAS};
+
+//
+// Allocate the R vector for one field of the lth estimate (its length is known without building anything)
+//
+SEXP lazyPathAlloc(const LazyPath& lp, int l, int field){
+    bool real = (field == LAZY_VALS || field == LAZY_SIGMAS);
+    R_xlen_t n = (field == LAZY_SIGMAS) ? lp.path.dim() : lp.nedges[l];
+    return Rf_allocVector(real ? REALSXP : INTSXP, n);
+}
+
+//
+// Fill out (allocated by lazyPathAlloc) with one field of the lth estimate
+//
+//   NOTES:
+//     -this is the only part that runs C++ code that can throw, and it never calls into R, so callers that are
+//      not inside an Rcpp export (the ALTREP methods) can catch everything here and turn it into an R error
+//
+void lazyPathFill(const LazyPath& lp, int l, int field, SEXP out){
+    if(field == LAZY_SIGMAS){
+        for(int j = 0; j < lp.path.dim(); ++j) REAL(out)[j] = lp.path.sigma(l, j);
+        return;
+    }
+
+    EdgeArrays edges(lp.path.dim(), EDGES_TRIPLET, lp.base);
+    edges.append(lp.path, l);
+    if(static_cast<R_xlen_t>(edges.vals.size()) != XLENGTH(out)){
+        throw std::logic_error("edge count does not match the length of the lazy vector");
+    }
+
+    if(field == LAZY_VALS){
+        std::copy(edges.vals.begin(), edges.vals.end(), REAL(out));
+    } else{
+        const std::vector<int>& idx = (field == LAZY_ROWS) ? edges.rows : edges.cols;
+        std::copy(idx.begin(), idx.end(), INTEGER(out));
+    }
+}
+
+//
+// Build one field of the lth estimate as a regular R vector
+//
+SEXP lazyPathField(const LazyPath& lp, int l, int field){
+    SEXP out = PROTECT(lazyPathAlloc(lp, l, field));
+    lazyPathFill(lp, l, field, out);
+    UNPROTECT(1);
+
+    return out;
+}
+
+#ifdef _CCDR_HAS_ALTREP_
+
+//
+// Each lazy vector stores data1 = list(<external pointer to the LazyPath>, c(l, field)) and data2 = the
+//   materialized vector (NULL until it is first needed)
+//
+static R_altrep_class_t lazyIntClass;
+static R_altrep_class_t lazyRealClass;
+
+static const LazyPath& lazyPathOf(SEXP x){
+    SEXP xp = VECTOR_ELT(R_altrep_data1(x), 0);
+    return *static_cast<LazyPath*>(R_ExternalPtrAddr(xp));
+}
+
+static int lazyIndex(SEXP x, int k){
+    return INTEGER(VECTOR_ELT(R_altrep_data1(x), 1))[k];
+}
+
+//
+// The ALTREP methods are called straight from R's C code, so a C++ exception must not escape them. Anything thrown
+//   while building the vector is turned into an R error here, once every C++ object is gone (Rf_error does not
+//   return, and would skip their destructors).
+//
+static SEXP lazyMaterialize(SEXP x){
+    SEXP data2 = R_altrep_data2(x);
+    if(data2 != R_NilValue) return data2;
+
+    const LazyPath& lp = lazyPathOf(x);
+    int l = lazyIndex(x, 0);
+    int field = lazyIndex(x, 1);
+    data2 = PROTECT(lazyPathAlloc(lp, l, field));
+
+    bool failed = false;
+    char msg[256];
+    try{
+        lazyPathFill(lp, l, field, data2);
+    } catch(std::exception& e){
+        failed = true;
+        snprintf(msg, sizeof(msg), "%s", e.what());
+    } catch(...){
+        failed = true;
+        snprintf(msg, sizeof(msg), "unknown C++ exception");
+    }
+
+    if(failed){
+        UNPROTECT(1);
+        Rf_error("could not build estimate %d of the lazy path: %s", l + 1, msg);
+    }
+
+    R_set_altrep_data2(x, data2);
+    UNPROTECT(1);
+
+    return data2;
+}
+
+static R_xlen_t lazyLength(SEXP x){
+    const LazyPath& lp = lazyPathOf(x);
+    return (lazyIndex(x, 1) == LAZY_SIGMAS) ? lp.path.dim() : lp.nedges[lazyIndex(x, 0)];
+}
+
+static void* lazyDataptr(SEXP x, Rboolean writeable){
+    SEXP data2 = lazyMaterialize(x);
+    return (TYPEOF(data2) == REALSXP) ? static_cast<void*>(REAL(data2)) : static_cast<void*>(INTEGER(data2));
+}
+
+static const void* lazyDataptrOrNull(SEXP x){
+    SEXP data2 = R_altrep_data2(x);
+    if(data2 == R_NilValue) return NULL;
+
+    return (TYPEOF(data2) == REALSXP) ? static_cast<const void*>(REAL(data2)) : static_cast<const void*>(INTEGER(data2));
+}
+
+static int lazyIntElt(SEXP x, R_xlen_t i){
+    return INTEGER(lazyMaterialize(x))[i];
+}
+
+static double lazyRealElt(SEXP x, R_xlen_t i){
+    return REAL(lazyMaterialize(x))[i];
+}
+
+static Rboolean lazyInspect(SEXP x, int pre, int deep, int pvec, void (*inspect_subtree)(SEXP, int, int, int)){
+    Rprintf("ccdr lazy path vector (estimate %d, field %d, %s)\n", lazyIndex(x, 0) + 1, lazyIndex(x, 1),
+            (R_altrep_data2(x) == R_NilValue) ? "not materialized" : "materialized");
+    return TRUE;
+}
+
+static SEXP lazyVector(SEXP xp, int l, int field){
+    SEXP idx = PROTECT(Rf_allocVector(INTSXP, 2));
+    INTEGER(idx)[0] = l;
+    INTEGER(idx)[1] = field;
+
+    SEXP data1 = PROTECT(Rf_allocVector(VECSXP, 2));
+    SET_VECTOR_ELT(data1, 0, xp);
+    SET_VECTOR_ELT(data1, 1, idx);
+
+    bool real = (field == LAZY_VALS || field == LAZY_SIGMAS);
+    SEXP out = R_new_altrep(real ? lazyRealClass : lazyIntClass, data1, R_NilValue);
+    UNPROTECT(2);
+
+    return out;
+}
+
+void registerLazyPathClasses(DllInfo* dll){
+    lazyIntClass = R_make_altinteger_class("ccdr_lazy_int", "Rccdr2", dll);
+    lazyRealClass = R_make_altreal_class("ccdr_lazy_real", "Rccdr2", dll);
+
+    R_altrep_class_t classes[2] = {lazyIntClass, lazyRealClass};
+    for(int k = 0; k < 2; ++k){
+        R_set_altrep_Length_method(classes[k], lazyLength);
+        R_set_altrep_Inspect_method(classes[k], lazyInspect);
+        R_set_altvec_Dataptr_method(classes[k], lazyDataptr);
+        R_set_altvec_Dataptr_or_null_method(classes[k], lazyDataptrOrNull);
+    }
+    R_set_altinteger_Elt_method(lazyIntClass, lazyIntElt);
+    R_set_altreal_Elt_method(lazyRealClass, lazyRealElt);
+}
+
+#else
+
+static SEXP lazyVector(SEXP xp, int l, int field){
+    return lazyPathField(*static_cast<LazyPath*>(R_ExternalPtrAddr(xp)), l, field);
+}
+
+void registerLazyPathClasses(DllInfo* /* dll */){
+}
+
+#endif
+
+static void lazyPathFinalizer(SEXP xp){
+    delete static_cast<LazyPath*>(R_ExternalPtrAddr(xp));
+    R_ClearExternalPtr(xp);
+}
+
+//
+// Hand the path over to R: returns list(rows, cols, vals, sigmas) for each estimate. The LazyPath is owned by R
+//   from here on.
+//
+SEXP lazyPathToR(LazyPath* lp){
+    SEXP xp = PROTECT(R_MakeExternalPtr(lp, R_NilValue, R_NilValue));
+    R_RegisterCFinalizerEx(xp, lazyPathFinalizer, TRUE);
+
+    int nlam = static_cast<int>(lp->path.size());
+    SEXP out = PROTECT(Rf_allocVector(VECSXP, nlam));
+    SEXP names = PROTECT(Rf_allocVector(STRSXP, 4));
+    SET_STRING_ELT(names, 0, Rf_mkChar("rows"));
+    SET_STRING_ELT(names, 1, Rf_mkChar("cols"));
+    SET_STRING_ELT(names, 2, Rf_mkChar("vals"));
+    SET_STRING_ELT(names, 3, Rf_mkChar("sigmas"));
+
+    for(int l = 0; l < nlam; ++l){
+        SEXP est = PROTECT(Rf_allocVector(VECSXP, 4));
+        for(int field = LAZY_ROWS; field <= LAZY_SIGMAS; ++field){
+            SET_VECTOR_ELT(est, field, lazyVector(xp, l, field));
+        }
+        Rf_setAttrib(est, R_NamesSymbol, names);
+        SET_VECTOR_ELT(out, l, est);
+        UNPROTECT(1);
+    }
+
+    UNPROTECT(3);
+    return out;
+}
+
+//
+// Count the edges of every estimate the same way EdgeArrays does (see ZERO_THRESH), so that the lazy vectors
+//   know their length without being built
+//
+void countLazyPathEdges(LazyPath& lp){
+    lp.nedges.assign(lp.path.size(), 0);
+    for(size_t l = 0; l < lp.path.size(); ++l){
+        for(int j = 0; j < lp.path.dim(); ++j){
+            const double* vals = lp.path.valptr(l, j);
+            for(int k = 0; k < lp.path.rowsizes(l, j); ++k){
+                if(fabs(vals[k]) > ZERO_THRESH) lp.nedges[l]++;
+            }
+        }
+    }
+}
+
+#endif
@@ -33,6 +33,7 @@
 
 // #include "defines.h" // deprecated; only needed for building outside R
 #include "algorithm.h"
+#include "altrep_path.h"
 
 using namespace Rcpp;
 
@@ -62,42 +63,13 @@ using namespace Rcpp;
 //      wrap<>: convert C++ to Rcpp object (type handled automatically)
 //
 
-// // [[Rcpp::export]]
-// List gridCCDr(NumericVector cors,
-//               List init_betas,
-//               unsigned int nn,
-//               NumericVector lambdas,
-//               NumericVector params,
-//               int verbose
-//               ){
-//     SparseMatrix betas = SparseMatrix(init_betas);
-//
-//     #ifdef _DEBUG_ON_
-//         //
-//         // log.h logging
-//         //
-//         FILE* pFile = fopen("/Users/Zigmund/Desktop/ccdr_proj_LOG_FILE.txt", "w");
-//         Output2FILE::Stream() = pFile;
-//         FILELog::ReportingLevel() = logDEBUG1;
-//
-//         FILE_LOG(logINFO) << "Log file opened.";
-//     #endif
-//
-//     std::vector<SparseMatrix> grid_betas;
-//     grid_betas = gridCCDr(as< std::vector<double> >(cors),
-//                           betas,
-//                           nn,
-//                           as< std::vector<double> >(lambdas),
-//                           as< std::vector<double> >(params),
-//                           verbose);
-//
-//     std::vector<List> return_betas;
-//     for(int i = 0; i < grid_betas.size(); ++i){
-//         return_betas.push_back(grid_betas[i].get_R(lambdas[i]));
-//     }
-//
-//     return wrap(return_betas);
-// }
+//
+// Declared at the top of every export that runs the algorithm: however the run ends, every thread then returns its
+//   cached column buffers to the system (see ColumnPool.h), so that nothing is held on to between calls from R
+//
+struct RunScope{
+    ~RunScope(){ ThreadPool::releaseColumnCaches(); }
+};
 
 // [[Rcpp::export]]
 List singleCCDr(NumericVector cors,
@@ -109,6 +81,7 @@ List singleCCDr(NumericVector cors,
                 IntegerVector blocks,
                 int verbose
                 ){
+    RunScope run;
 
     #ifdef _DEBUG_ON_
         //
@@ -123,20 +96,21 @@ List singleCCDr(NumericVector cors,
 
     SparseMatrix betas = SparseMatrix(init_betas);
 
-    std::vector<std::vector<int> > blocks_mat;
-    for(int k = 0; k < blocks.size(); k += 2){
-        blocks_mat.push_back({blocks[k], blocks[k+1]});
-    }
+    // blocks is already in the flat (row, col, row, col, ...) layout used by BlockList
+    BlockList blocklist = BlockList(std::vector<int>(blocks.begin(), blocks.end()), betas.dim());
 
-    BlockList blocklist = BlockList(blocks_mat);
-    betas = singleCCDr(as< std::vector<double> >(cors),
-                       betas,
-                       as< std::vector<double> >(init_sigmas),
-                       nn,
-                       lambda,
-                       as< std::vector<double> >(params),
-                       verbose,
-                       blocklist);
+    // expand the packed correlations straight from R's memory (no intermediate std::vector)
+    Matrix<double> cormat = cor_vector_to_Matrix(cors.begin(), betas.dim());
+    std::vector<double> params_in = as< std::vector<double> >(params);
+    singleCCDr(cormat,
+               betas,
+               as< std::vector<double> >(init_sigmas),
+               nn,
+               lambda,
+               params_in,
+               verbose,
+               blocklist,
+               budgetFromParams(params_in, 6));
     //
     // Need to manually recompute active set size when calling singleCCDr directly from R,
     //   as opposed to within gridCCDr, which automatically recomputes the active set size
@@ -147,6 +121,831 @@ List singleCCDr(NumericVector cors,
     return betas.get_R(lambda);
 }
 
+//
+// Convert a SolutionPath into an R list with one element (as returned by SparseMatrix::get_R) per estimate
+//
+List pathToList(const SolutionPath& path){
+    List out(path.size());
+    for(size_t l = 0; l < path.size(); ++l){
+        SparseMatrix est = path.materialize(l);
+        out[l] = est.get_R(path.lambda(l));
+    }
+
+    return out;
+}
+
+//
+// Convert the per-lambda stats into an R list of equal-length vectors (one element per estimate)
+//
+List statsToList(const std::vector<LambdaStats>& stats){
+    size_t n = stats.size();
+    NumericVector lambda(n), seconds(n);
+    IntegerVector nedges(n), iters(n);
+    CharacterVector status(n);
+
+    for(size_t l = 0; l < n; ++l){
+        lambda[l] = stats[l].lambda;
+        seconds[l] = stats[l].seconds;
+        nedges[l] = stats[l].nedges;
+        iters[l] = stats[l].iters;
+        status[l] = stopReasonName(stats[l].status);
+    }
+
+    return List::create(_["lambda"] = lambda, _["nedges"] = nedges, _["seconds"] = seconds, _["iters"] = iters, _["status"] = status);
+}
+
+//
+// Run gridCCDr over the whole grid of lambdas in one call: the warm starts stay in C++ between values of lambda,
+//   and the path is only converted to R objects once it is finished
+//
+// Returns list(path = <one element per estimate, as returned by singleCCDr>, stats = <see statsToList>)
+//
+// [[Rcpp::export]]
+List gridCCDrNative(NumericVector cors,
+                    List init_betas,
+                    NumericVector init_sigmas,
+                    unsigned int nn,
+                    NumericVector lambdas,
+                    NumericVector params,
+                    IntegerVector blocks,
+                    int verbose
+                    ){
+    RunScope run;
+
+    SparseMatrix betas = SparseMatrix(init_betas);
+    BlockList blocklist = BlockList(std::vector<int>(blocks.begin(), blocks.end()), betas.dim());
+
+    MemoryPathSink sink;
+    gridCCDr(cor_vector_to_Matrix(cors.begin(), betas.dim()),
+             std::move(betas),
+             as< std::vector<double> >(init_sigmas),
+             nn,
+             as< std::vector<double> >(lambdas),
+             as< std::vector<double> >(params),
+             verbose,
+             blocklist,
+             sink);
+
+    return List::create(_["path"] = pathToList(sink.path()),
+                        _["stats"] = statsToList(sink.stats()));
+}
+
+//
+// Same as gridCCDrNative, but takes the full (symmetric) correlation matrix, e.g. straight from crossprod. The
+//   matrix is used in place (see Matrix.h): nothing is copied, and no packing is needed in R.
+//
+// [[Rcpp::export]]
+List gridCCDrFullMatrix(NumericMatrix cors,
+                        List init_betas,
+                        NumericVector init_sigmas,
+                        unsigned int nn,
+                        NumericVector lambdas,
+                        NumericVector params,
+                        IntegerVector blocks,
+                        int verbose
+                        ){
+    RunScope run;
+
+    SparseMatrix betas = SparseMatrix(init_betas);
+    if(cors.nrow() != betas.dim() || cors.ncol() != betas.dim()){
+        stop("cors must be a square matrix with one row / column per node!");
+    }
+    BlockList blocklist = BlockList(std::vector<int>(blocks.begin(), blocks.end()), betas.dim());
+
+    MemoryPathSink sink;
+    gridCCDr(Matrix<double>(cors.begin(), cors.nrow(), cors.ncol()),
+             std::move(betas),
+             as< std::vector<double> >(init_sigmas),
+             nn,
+             as< std::vector<double> >(lambdas),
+             as< std::vector<double> >(params),
+             verbose,
+             blocklist,
+             sink);
+
+    return List::create(_["path"] = pathToList(sink.path()),
+                        _["stats"] = statsToList(sink.stats()));
+}
+
+//
+// Correlations from R, as either the packed upper triangle (expanded once) or the full matrix (used in place, see
+//   Matrix.h). A full matrix must already be stored as doubles: a converted copy would not outlive this call.
+//
+Matrix<double> corsFromR(SEXP cors, int pp){
+    if(Rf_isMatrix(cors)){
+        if(TYPEOF(cors) != REALSXP) stop("cors must be a numeric (double) matrix!");
+        if(Rf_nrows(cors) != pp || Rf_ncols(cors) != pp) stop("cors must be a square matrix with one row / column per node!");
+
+        return Matrix<double>(REAL(cors), pp, pp);
+    }
+
+    NumericVector packed(cors);
+    if(packed.size() != pp * (pp + 1) / 2) stop("cors has incorrect length!");
+
+    return cor_vector_to_Matrix(packed.begin(), pp);
+}
+
+//
+// Node indices with shift added (e.g. 1 for 0-based indices going to R)
+//
+IntegerVector shiftedIndices(const std::vector<int>& idx, int shift){
+    IntegerVector out(idx.size());
+    for(size_t k = 0; k < idx.size(); ++k) out[k] = idx[k] + shift;
+
+    return out;
+}
+
+//
+// A path stored as EdgeArrays, as returned by gridCCDrEdges (without the stats); shift is added to the node
+//   indices on the way out
+//
+List edgeArraysToList(const EdgeArrays& edges, int pp, bool csc, int shift = 0){
+    NumericMatrix sigmas(pp, static_cast<int>(edges.size()));
+    std::copy(edges.sigmas.begin(), edges.sigmas.end(), sigmas.begin());
+
+    // colptr for "csc", cols for "triplet"
+    return List::create(_["lambda"] = wrap(edges.lambdas),
+                        _["nedge"] = wrap(edges.nedges),
+                        _["offsets"] = NumericVector(edges.offsets.begin(), edges.offsets.end()), // may not fit in an int
+                        _["rows"] = shiftedIndices(edges.rows, shift),
+                        _[csc ? "colptr" : "cols"] = csc ? wrap(edges.colptr) : wrap(shiftedIndices(edges.cols, shift)),
+                        _["vals"] = wrap(edges.vals),
+                        _["sigmas"] = sigmas);
+}
+
+//
+// The path collected by an EdgeArrayPathSink, as returned by gridCCDrEdges
+//
+List edgeSinkToList(EdgeArrayPathSink& sink, int pp, bool csc){
+    List out = edgeArraysToList(sink.edges(), pp, csc);
+    out["stats"] = statsToList(sink.stats());
+
+    return out;
+}
+
+//
+// Run gridCCDr over the whole grid of lambdas and return the path as flat arrays (see EdgeArrays.h) instead of one
+//   list per estimate: format is "triplet" or "csc", and base (0 or 1) is added to every node index. cors can be
+//   either packed or the full matrix (see corsFromR).
+//
+// [[Rcpp::export]]
+List gridCCDrEdges(SEXP cors,
+                   List init_betas,
+                   NumericVector init_sigmas,
+                   unsigned int nn,
+                   NumericVector lambdas,
+                   NumericVector params,
+                   IntegerVector blocks,
+                   int verbose,
+                   std::string format,
+                   int base
+                   ){
+    RunScope run;
+
+    if(format != "triplet" && format != "csc") stop("format must be either 'triplet' or 'csc'!");
+    if(base != 0 && base != 1) stop("base must be either 0 or 1!");
+
+    SparseMatrix betas = SparseMatrix(init_betas);
+    int pp = betas.dim();
+    BlockList blocklist = BlockList(std::vector<int>(blocks.begin(), blocks.end()), pp);
+
+    EdgeArrayPathSink sink(pp, format == "csc" ? EDGES_CSC : EDGES_TRIPLET, base);
+    gridCCDr(corsFromR(cors, pp),
+             std::move(betas),
+             as< std::vector<double> >(init_sigmas),
+             nn,
+             as< std::vector<double> >(lambdas),
+             as< std::vector<double> >(params),
+             verbose,
+             blocklist,
+             sink);
+
+    return edgeSinkToList(sink, pp, format == "csc");
+}
+
+//
+// Same as gridCCDrEdges, but relabels the nodes first to improve memory locality (see reorderedGridCCDr). The
+//   estimates are mapped back to the original labels, so the path is the same as from gridCCDrEdges.
+//
+// [[Rcpp::export]]
+List gridCCDrReordered(SEXP cors,
+                       List init_betas,
+                       NumericVector init_sigmas,
+                       unsigned int nn,
+                       NumericVector lambdas,
+                       NumericVector params,
+                       IntegerVector blocks,
+                       int verbose,
+                       std::string format,
+                       int base
+                       ){
+    RunScope run;
+
+    if(format != "triplet" && format != "csc") stop("format must be either 'triplet' or 'csc'!");
+    if(base != 0 && base != 1) stop("base must be either 0 or 1!");
+
+    SparseMatrix betas = SparseMatrix(init_betas);
+    int pp = betas.dim();
+    BlockList blocklist = BlockList(std::vector<int>(blocks.begin(), blocks.end()), pp);
+
+    EdgeArrayPathSink sink(pp, format == "csc" ? EDGES_CSC : EDGES_TRIPLET, base);
+    reorderedGridCCDr(corsFromR(cors, pp),
+                      betas,
+                      as< std::vector<double> >(init_sigmas),
+                      nn,
+                      as< std::vector<double> >(lambdas),
+                      as< std::vector<double> >(params),
+                      verbose,
+                      blocklist,
+                      sink);
+
+    return edgeSinkToList(sink, pp, format == "csc");
+}
+
+//
+// Run gridCCDr over the whole grid of lambdas and keep the path in C++: the estimates are returned as lazy
+//   (rows, cols, vals, sigmas) vectors that are only built when R touches them (see altrep_path.h). Indices are
+//   shifted by base (0 or 1) as in gridCCDrEdges.
+//
+// [[Rcpp::export]]
+List gridCCDrLazy(SEXP cors,
+                  List init_betas,
+                  NumericVector init_sigmas,
+                  unsigned int nn,
+                  NumericVector lambdas,
+                  NumericVector params,
+                  IntegerVector blocks,
+                  int verbose,
+                  int base
+                  ){
+    RunScope run;
+
+    if(base != 0 && base != 1) stop("base must be either 0 or 1!");
+
+    SparseMatrix betas = SparseMatrix(init_betas);
+    int pp = betas.dim();
+    BlockList blocklist = BlockList(std::vector<int>(blocks.begin(), blocks.end()), pp);
+
+    MemoryPathSink sink;
+    gridCCDr(corsFromR(cors, pp),
+             std::move(betas),
+             as< std::vector<double> >(init_sigmas),
+             nn,
+             as< std::vector<double> >(lambdas),
+             as< std::vector<double> >(params),
+             verbose,
+             blocklist,
+             sink);
+
+    std::unique_ptr<LazyPath> lp(new LazyPath);
+    lp->path = std::move(sink.path());
+    lp->base = base;
+    countLazyPathEdges(*lp);
+
+    std::vector<double> lambda_out(lp->path.size());
+    for(size_t l = 0; l < lp->path.size(); ++l) lambda_out[l] = lp->path.lambda(l);
+    IntegerVector nedge = wrap(lp->nedges);
+
+    List edges = lazyPathToR(lp.release()); // R owns the path from here on
+    return List::create(_["lambda"] = wrap(lambda_out),
+                        _["nedge"] = nedge,
+                        _["edges"] = edges,
+                        _["stats"] = statsToList(sink.stats()));
+}
+
+//
+// Helpers for the screening exports: checks the rule / threads / column order (1-based, possibly empty) passed from
+//   R, and returns the screened pairs as a two-column integer matrix of 1-based (row, col) pairs, like matrix2blocks
+//
+screenRule screenRuleFromR(const std::string& rule, int threads){
+    if(rule != "and" && rule != "or") stop("rule must be either \"and\" or \"or\"!");
+    if(threads < 0) stop("threads must be nonnegative!");
+
+    return (rule == "and") ? SCREEN_AND : SCREEN_OR;
+}
+
+std::vector<int> screenOrderFromR(IntegerVector order, int pp){
+    if(order.size() != 0 && order.size() != pp) stop("order must be empty or have one entry per node!");
+
+    std::vector<int> node_order(order.begin(), order.end());
+    std::vector<bool> seen(pp, false);
+    for(size_t j = 0; j < node_order.size(); ++j){
+        if(node_order[j] < 1 || node_order[j] > pp || seen[node_order[j] - 1]) stop("order must be a permutation of the nodes!");
+        seen[--node_order[j]] = true;
+    }
+
+    return node_order;
+}
+
+IntegerMatrix screenPairsToR(const std::vector<int>& pairs){
+    int npairs = static_cast<int>(pairs.size() / 2);
+    IntegerMatrix out(npairs, 2);
+    for(int k = 0; k < npairs; ++k){
+        out(k, 0) = pairs[2*k] + 1;
+        out(k, 1) = pairs[2*k + 1] + 1;
+    }
+
+    return out;
+}
+
+//
+// Build the screening graph by neighbourhood selection (see screening.h): rule is either "and" or "or", threads = 0
+//   uses one thread per core, and order is the order in which the columns are listed.
+//
+// Returns the candidate edges grouped by column, one row per direction (see screenPairsToR)
+//
+// [[Rcpp::export]]
+IntegerMatrix screenNeighbourhoods(SEXP cors,
+                                   int pp,
+                                   double lambda,
+                                   std::string rule,
+                                   int threads,
+                                   IntegerVector order
+                                   ){
+    screenRule screen_rule = screenRuleFromR(rule, threads);
+    if(lambda < 0) stop("lambda must be nonnegative!");
+
+    return screenPairsToR(screenPairs(corsFromR(cors, pp),
+                                      lambda,
+                                      screen_rule,
+                                      static_cast<unsigned int>(threads),
+                                      screenOrderFromR(order, pp)));
+}
+
+//
+// Build the screening graph by marginal screening (see screening.h): each node keeps the partners with absolute
+//   correlation above threshold, at most k of them (the largest) if k > 0. Other arguments and the output are as in
+//   screenNeighbourhoods.
+//
+// [[Rcpp::export]]
+IntegerMatrix screenMarginal(SEXP cors,
+                             int pp,
+                             int k,
+                             double threshold,
+                             std::string rule,
+                             int threads,
+                             IntegerVector order
+                             ){
+    screenRule screen_rule = screenRuleFromR(rule, threads);
+    if(k < 0) stop("k must be nonnegative!");
+    if(threshold < 0) stop("threshold must be nonnegative!");
+
+    return screenPairsToR(marginalScreenPairs(corsFromR(cors, pp),
+                                              k,
+                                              threshold,
+                                              screen_rule,
+                                              static_cast<unsigned int>(threads),
+                                              screenOrderFromR(order, pp)));
+}
+
+//
+// Order the nodes by decreasing largest (stat = "max") or total (stat = "sum") absolute off-diagonal entry of their
+//   column of cors, packed or full (see nodeOrder in screening.h). Packed input is read in one pass, in place.
+//
+// Returns the order as 1-based node indices, as from order(..., decreasing = TRUE) in R
+//
+// [[Rcpp::export]]
+IntegerVector nodeOrderNative(SEXP cors,
+                              int pp,
+                              std::string stat,
+                              int threads
+                              ){
+    if(stat != "max" && stat != "sum") stop("stat must be either \"max\" or \"sum\"!");
+    if(threads < 0) stop("threads must be nonnegative!");
+
+    nodeOrderStat order_stat = (stat == "max") ? ORDER_BY_MAX : ORDER_BY_SUM;
+    std::vector<double> colstats;
+    if(Rf_isMatrix(cors)){
+        colstats = columnStats(corsFromR(cors, pp), order_stat, static_cast<unsigned int>(threads));
+    } else{
+        NumericVector packed(cors);
+        if(packed.size() != pp * (pp + 1) / 2) stop("cors has incorrect length!");
+
+        colstats = packedColumnStats(packed.begin(), pp, order_stat, static_cast<unsigned int>(threads));
+    }
+
+    std::vector<int> order = nodeOrder(colstats);
+    for(size_t j = 0; j < order.size(); ++j) order[j]++;
+
+    return wrap(order);
+}
+
+//
+// Every ordered pair of distinct nodes, grouped by column in the order of nodes (the same as allBlocks in R, see
+//   fillAllPairs), written straight into the two columns of the output matrix
+//
+// [[Rcpp::export]]
+IntegerMatrix allBlocksNative(IntegerVector nodes,
+                              int threads
+                              ){
+    if(threads < 0) stop("threads must be nonnegative!");
+
+    std::vector<int> node_vec(nodes.begin(), nodes.end());
+    size_t n = node_vec.size();
+    size_t npairs = n * ((n > 0) ? n - 1 : 0);
+    if(npairs > static_cast<size_t>(std::numeric_limits<int>::max())) stop("Too many nodes to list every pair!");
+
+    IntegerMatrix out(static_cast<int>(npairs), 2);
+    if(npairs > 0) fillAllPairs(node_vec, out.begin(), out.begin() + npairs, 1, static_cast<unsigned int>(threads));
+
+    return out;
+}
+
+//
+// Same as gridCCDrEdges, but splits the problem into the connected components of the graph of blocks and solves
+//   them in parallel (see componentGridCCDr); also returns the number of components. The estimates are those of
+//   each component on its own, so they can differ from those of gridCCDrEdges (see NOTES there).
+//
+// [[Rcpp::export]]
+List gridCCDrComponents(SEXP cors,
+                        List init_betas,
+                        NumericVector init_sigmas,
+                        unsigned int nn,
+                        NumericVector lambdas,
+                        NumericVector params,
+                        IntegerVector blocks,
+                        int verbose,
+                        std::string format,
+                        int base,
+                        int threads
+                        ){
+    RunScope run;
+
+    if(format != "triplet" && format != "csc") stop("format must be either 'triplet' or 'csc'!");
+    if(base != 0 && base != 1) stop("base must be either 0 or 1!");
+    if(threads < 0) stop("threads must be nonnegative!");
+
+    SparseMatrix betas = SparseMatrix(init_betas);
+    int pp = betas.dim();
+    BlockList blocklist = BlockList(std::vector<int>(blocks.begin(), blocks.end()), pp);
+
+    EdgeArrayPathSink sink(pp, format == "csc" ? EDGES_CSC : EDGES_TRIPLET, base);
+    unsigned int ncomponents = componentGridCCDr(corsFromR(cors, pp),
+                                                 betas,
+                                                 as< std::vector<double> >(init_sigmas),
+                                                 nn,
+                                                 as< std::vector<double> >(lambdas),
+                                                 as< std::vector<double> >(params),
+                                                 verbose,
+                                                 blocklist,
+                                                 sink,
+                                                 static_cast<unsigned int>(threads));
+
+    List out = edgeSinkToList(sink, pp, format == "csc");
+    out["ncomponents"] = static_cast<int>(ncomponents);
+
+    return out;
+}
+
+//
+// Same as gridCCDrEdges, but splits the grid into independent parts that are solved in parallel, each started from
+//   the initial betas (see parallelGridCCDr), so the path differs from gridCCDrEdges after the first part. cors is
+//   either packed or the full matrix (see corsFromR). The path depends on the number of segments only, not on the
+//   number of threads. Also returns the number of solves and of segments.
+//
+// [[Rcpp::export]]
+List gridCCDrParallel(SEXP cors,
+                      List init_betas,
+                      NumericVector init_sigmas,
+                      unsigned int nn,
+                      NumericVector lambdas,
+                      NumericVector params,
+                      IntegerVector blocks,
+                      int verbose,
+                      std::string format,
+                      int base,
+                      int segments,
+                      int threads
+                      ){
+    RunScope run;
+
+    if(format != "triplet" && format != "csc") stop("format must be either 'triplet' or 'csc'!");
+    if(base != 0 && base != 1) stop("base must be either 0 or 1!");
+    if(segments < 1) stop("segments must be positive!");
+    if(threads < 0) stop("threads must be nonnegative!");
+
+    SparseMatrix betas = SparseMatrix(init_betas);
+    int pp = betas.dim();
+    BlockList blocklist = BlockList(std::vector<int>(blocks.begin(), blocks.end()), pp);
+
+    EdgeArrayPathSink sink(pp, format == "csc" ? EDGES_CSC : EDGES_TRIPLET, base);
+    ParallelPathStats pstats = parallelGridCCDr(corsFromR(cors, pp),
+                                                betas,
+                                                as< std::vector<double> >(init_sigmas),
+                                                nn,
+                                                as< std::vector<double> >(lambdas),
+                                                as< std::vector<double> >(params),
+                                                verbose,
+                                                blocklist,
+                                                sink,
+                                                static_cast<unsigned int>(segments),
+                                                static_cast<unsigned int>(threads));
+
+    List out = edgeSinkToList(sink, pp, format == "csc");
+    out["parallel"] = List::create(_["solves"] = static_cast<int>(pstats.solves),
+                                   _["segments"] = static_cast<int>(pstats.segments));
+
+    return out;
+}
+
+//
+// Run 'copies' randomized copies of gridCCDr in parallel (see ensembleGridCCDr) and return, for each value of lambda,
+//   how many copies selected each edge: the edges of the lth value of lambda are entries
+//   [offsets[l], offsets[l+1]) of rows / cols / count, and nfits[l] copies have an estimate for it. With
+//   keep_paths = TRUE, the path of each copy is also returned, as by gridCCDrEdges (triplet format, without stats).
+//   base (0 or 1) is added to every node index.
+//
+// [[Rcpp::export]]
+List gridCCDrEnsemble(SEXP cors,
+                      List init_betas,
+                      NumericVector init_sigmas,
+                      unsigned int nn,
+                      NumericVector lambdas,
+                      NumericVector params,
+                      IntegerVector blocks,
+                      int verbose,
+                      int copies,
+                      bool keep_paths,
+                      int base,
+                      int threads
+                      ){
+    RunScope run;
+
+    if(copies <= 0) stop("copies must be positive!");
+    if(base != 0 && base != 1) stop("base must be either 0 or 1!");
+    if(threads < 0) stop("threads must be nonnegative!");
+
+    SparseMatrix betas = SparseMatrix(init_betas);
+    int pp = betas.dim();
+    BlockList blocklist = BlockList(std::vector<int>(blocks.begin(), blocks.end()), pp);
+
+    std::vector<EdgeArrays> paths;
+    EdgeFrequencies freq = ensembleGridCCDr(corsFromR(cors, pp),
+                                            betas,
+                                            as< std::vector<double> >(init_sigmas),
+                                            nn,
+                                            as< std::vector<double> >(lambdas),
+                                            as< std::vector<double> >(params),
+                                            verbose,
+                                            blocklist,
+                                            static_cast<unsigned int>(copies),
+                                            static_cast<unsigned int>(threads),
+                                            keep_paths ? &paths : NULL);
+
+    List path_list(paths.size());
+    for(size_t r = 0; r < paths.size(); ++r){
+        path_list[r] = edgeArraysToList(paths[r], pp, false, base);
+    }
+
+    return List::create(_["lambda"] = wrap(freq.lambdas),
+                        _["nfits"] = wrap(freq.nfits),
+                        _["offsets"] = NumericVector(freq.offsets.begin(), freq.offsets.end()),
+                        _["rows"] = shiftedIndices(freq.rows, base),
+                        _["cols"] = shiftedIndices(freq.cols, base),
+                        _["count"] = wrap(freq.counts),
+                        _["paths"] = keep_paths ? RObject(path_list) : RObject(R_NilValue));
+}
+
+//
+// Run gridCCDr over the whole grid of lambdas, writing a checkpoint to checkpoint_file after every
+//   checkpoint_every values of lambda (see checkpoint.h); if the job is killed, call gridCCDrResume with the
+//   same file to continue where it left off
+//
+// [[Rcpp::export]]
+List gridCCDrCheckpointed(NumericVector cors,
+                          List init_betas,
+                          NumericVector init_sigmas,
+                          unsigned int nn,
+                          NumericVector lambdas,
+                          NumericVector params,
+                          IntegerVector blocks,
+                          int verbose,
+                          std::string checkpoint_file,
+                          unsigned int checkpoint_every
+                          ){
+    RunScope run;
+
+    SparseMatrix betas = SparseMatrix(init_betas);
+    BlockList blocklist = BlockList(std::vector<int>(blocks.begin(), blocks.end()), betas.dim());
+
+    MemoryPathSink sink;
+    checkpointedGridCCDr(as< std::vector<double> >(cors),
+                         std::move(betas),
+                         as< std::vector<double> >(init_sigmas),
+                         nn,
+                         as< std::vector<double> >(lambdas),
+                         as< std::vector<double> >(params),
+                         verbose,
+                         blocklist,
+                         sink,
+                         checkpoint_file,
+                         checkpoint_every);
+
+    return pathToList(sink.path());
+}
+
+//
+// Continue a gridCCDrCheckpointed run from its checkpoint; cors and blocks must be the same as in the original
+//   call. Returns the whole path, including the estimates computed before the checkpoint; with keep > 0, only
+//   the last 'keep' estimates are kept and returned (see LastKPathSink).
+//
+// [[Rcpp::export]]
+List gridCCDrResume(std::string checkpoint_file,
+                    NumericVector cors,
+                    IntegerVector blocks,
+                    int verbose,
+                    unsigned int checkpoint_every,
+                    unsigned int keep
+                    ){
+    RunScope run;
+
+    // cors holds the lower triangle of a pp x pp matrix
+    int pp = static_cast<int>((sqrt(8.0 * cors.size() + 1) - 1) / 2 + 0.5);
+    BlockList blocklist = BlockList(std::vector<int>(blocks.begin(), blocks.end()), pp);
+
+    auto resume = [&](PathSink& sink){
+        if(!resumeGridCCDr(checkpoint_file,
+                           as< std::vector<double> >(cors),
+                           verbose,
+                           blocklist,
+                           sink,
+                           checkpoint_every)){
+            stop("Could not resume from " + checkpoint_file + ".");
+        }
+    };
+
+    if(keep == 0){
+        MemoryPathSink sink;
+        resume(sink);
+        return pathToList(sink.path());
+    }
+
+    LastKPathSink sink(keep);
+    resume(sink);
+
+    List out(sink.size());
+    for(size_t k = 0; k < sink.size(); ++k){
+        SparseMatrix est = sink.estimate(k);
+        out[k] = est.get_R(sink.estimateStats(k).lambda);
+    }
+
+    return out;
+}
+
+//
+// Run gridCCDr over a coarse grid of lambdas, then refine the grid where the number of edges or the objective
+//   changes quickly, using at most max_fits calls to singleCCDr in total (see adaptiveGridCCDr)
+//
+// [[Rcpp::export]]
+List gridCCDrAdaptive(NumericVector cors,
+                      List init_betas,
+                      NumericVector init_sigmas,
+                      unsigned int nn,
+                      NumericVector lambdas,
+                      unsigned int max_fits,
+                      int max_edge_jump,
+                      double max_objective_jump,
+                      NumericVector params,
+                      IntegerVector blocks,
+                      int verbose
+                      ){
+    RunScope run;
+
+    SparseMatrix betas = SparseMatrix(init_betas);
+    BlockList blocklist = BlockList(std::vector<int>(blocks.begin(), blocks.end()), betas.dim());
+
+    MemoryPathSink sink;
+    adaptiveGridCCDr(as< std::vector<double> >(cors),
+                     std::move(betas),
+                     as< std::vector<double> >(init_sigmas),
+                     nn,
+                     as< std::vector<double> >(lambdas),
+                     max_fits,
+                     max_edge_jump,
+                     max_objective_jump,
+                     as< std::vector<double> >(params),
+                     verbose,
+                     blocklist,
+                     sink);
+
+    return pathToList(sink.path());
+}
+
+//
+// Find the estimate with about target_edges edges by bracketing and bisecting lambda (see targetEdgesCCDr)
+//
+// Returns list(best = <index of the closest fit, 1-based>, fits = <every fit, in order of decreasing lambda>)
+//
+// [[Rcpp::export]]
+List ccdrTargetEdges(NumericVector cors,
+                     List init_betas,
+                     NumericVector init_sigmas,
+                     unsigned int nn,
+                     int target_edges,
+                     double max_lambda,
+                     double min_lambda,
+                     unsigned int max_fits,
+                     NumericVector params,
+                     IntegerVector blocks,
+                     int verbose
+                     ){
+    RunScope run;
+
+    SparseMatrix betas = SparseMatrix(init_betas);
+    BlockList blocklist = BlockList(std::vector<int>(blocks.begin(), blocks.end()), betas.dim());
+
+    EdgeTargetResult result = targetEdgesCCDr(as< std::vector<double> >(cors),
+                                              std::move(betas),
+                                              as< std::vector<double> >(init_sigmas),
+                                              nn,
+                                              target_edges,
+                                              max_lambda,
+                                              min_lambda,
+                                              max_fits,
+                                              as< std::vector<double> >(params),
+                                              verbose,
+                                              blocklist);
+
+    return List::create(_["best"] = static_cast<int>(result.best) + 1,
+                        _["fits"] = pathToList(result.fits));
+}
+
+//
+// Report which variant of the numeric kernels (scalar / avx2 / avx512) was selected on this machine
+//   (see kernels.h)
+//
+// [[Rcpp::export]]
+std::string getKernelVariant(){
+    return kernelVariant();
+}
+
+//
+// Report how the pooled column storage of SparseMatrix (see ColumnPool.h) has been used so far by this process
+//   (i.e. the R thread): the number of buffers requested from the system, the number served from the pool,
+//   and the number of bytes currently cached
+//
+// [[Rcpp::export]]
+List getColumnPoolStats(){
+    ColumnPoolStats st = ColumnPool::local().stats();
+
+    return List::create(_["system_allocs"] = static_cast<double>(st.systemAllocs),
+                        _["pool_hits"] = static_cast<double>(st.poolHits),
+                        _["cached_bytes"] = static_cast<double>(st.cachedBytes));
+}
+
+//
+// Set the per-thread limit (in bytes) on the column buffers cached by ColumnPool (see ColumnPool.h); 0 turns the
+//   caching off. Returns the previous limit.
+//
+// [[Rcpp::export]]
+double setColumnPoolLimit(double bytes){
+    if(bytes < 0) stop("bytes must be nonnegative!");
+
+    double old = static_cast<double>(ColumnPool::cacheLimit());
+    ColumnPool::setCacheLimit(static_cast<std::size_t>(bytes));
+    return old;
+}
+
+//
+// Set the global thread cap (see ThreadPool.h): every parallel part of the algorithm shares one pool of threads,
+//   and never uses more than this many threads at once (0 = one per core). Returns the cap now in use.
+//
+// [[Rcpp::export]]
+int setThreadCap(int threads){
+    if(threads < 0) stop("threads must be nonnegative!");
+
+    ThreadPool::setThreadCap(static_cast<unsigned int>(threads));
+    return static_cast<int>(ThreadPool::threadCap());
+}
+
+//
+// The global thread cap currently in use (see setThreadCap)
+//
+// [[Rcpp::export]]
+int getThreadCap(){
+    return static_cast<int>(ThreadPool::threadCap());
+}
+
+//
+// Convert the (pooled) column storage of a SparseMatrix into an R list of vectors
+//
+template<int RTYPE, class Column>
+List columnsToList(const std::vector<Column>& cols){
+    List out(cols.size());
+    for(size_t j = 0; j < cols.size(); ++j){
+        out[j] = Vector<RTYPE>(cols[j].begin(), cols[j].end());
+    }
+
+    return out;
+}
+
+//
+// Called by R when the package is loaded; the routines themselves are still looked up by name (see RcppExports.R)
+//
+extern "C" void R_init_Rccdr2(DllInfo* dll){
+    registerLazyPathClasses(dll);
+}
+
 //---------------------------------------------------------------------------------------------------//
 // ***IF THIS CODE THROWS ANY ERRORS, MOVE THIS DEFINITION BACK TO THE END OF SparseMatrix.h***
 //
@@ -156,10 +955,14 @@ List singleCCDr(NumericVector cors,
 //  1) Include lambda in list (lambda_R >= 0)
 //  2) Ignore lambda (lambda_R < 0)
 List SparseMatrix::get_R(double lambda_R){
+    List rows_R = columnsToList<INTSXP>(rows);
+    List vals_R = columnsToList<REALSXP>(vals);
+    List blocks_R = columnsToList<INTSXP>(blocks);
+
     if(lambda_R < 0)
-        return List::create(_["rows"] = wrap(rows), _["vals"] = wrap(vals), _["sigmas"] = wrap(sigmas), _["blocks"] = wrap(blocks), _["length"] = wrap(activeSetLength));
+        return List::create(_["rows"] = rows_R, _["vals"] = vals_R, _["sigmas"] = wrap(sigmas), _["blocks"] = blocks_R, _["length"] = wrap(activeSetLength));
     else
-        return List::create(_["rows"] = wrap(rows), _["vals"] = wrap(vals), _["sigmas"] = wrap(sigmas), _["blocks"] = wrap(blocks), _["length"] = wrap(activeSetLength), _["lambda"] = wrap(lambda_R));
+        return List::create(_["rows"] = rows_R, _["vals"] = vals_R, _["sigmas"] = wrap(sigmas), _["blocks"] = blocks_R, _["length"] = wrap(activeSetLength), _["lambda"] = wrap(lambda_R));
 }
 //---------------------------------------------------------------------------------------------------//
 
@@ -0,0 +1,104 @@
+//
+//  alloctest.cpp
+//  ccdr2
+//
+
+//
+// Checks that, once the column pool (see ColumnPool.h) has warmed up, the coordinate descent sweeps run by
+//   singleCCDr (concaveCDInit + concaveCD over a fixed lambda) do not touch the heap at all: every call to the
+//   global operator new is counted, and the program fails if any of the repeated sweeps makes one.
+//
+// Build and run with "make alloctest". The debugging code is turned off, since the logging allocates.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+#include "defines.h"
+#undef _DEBUG_ON_
+#include "algorithm.h"
+
+static unsigned long numAllocs = 0;
+
+// (not inlined, so that the compiler does not pair the malloc / free below with new / delete expressions)
+__attribute__((noinline)) void* operator new(std::size_t bytes){
+    numAllocs++;
+    void* p = malloc(bytes);
+    if(p == NULL) throw std::bad_alloc();
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept{
+    free(p);
+}
+
+int main(){
+    const int pp = 60, nn = 100, NUM_SWEEPS = 20;
+
+    //
+    // Simulate data from a chain, standardize, and compute the correlations
+    //
+    std::mt19937 gen(1);
+    std::normal_distribution<double> rnorm(0, 1);
+    std::vector<double> X(nn * pp);
+    for(int j = 0; j < pp; ++j){
+        for(int i = 0; i < nn; ++i) X[j * nn + i] = rnorm(gen) + ((j > 0) ? 0.7 * X[(j - 1) * nn + i] : 0);
+    }
+    for(int j = 0; j < pp; ++j){
+        double m = 0, s = 0;
+        for(int i = 0; i < nn; ++i) m += X[j * nn + i] / nn;
+        for(int i = 0; i < nn; ++i) s += (X[j * nn + i] - m) * (X[j * nn + i] - m);
+        for(int i = 0; i < nn; ++i) X[j * nn + i] = (X[j * nn + i] - m) / sqrt(s);
+    }
+
+    std::vector<double> corvec;
+    for(int j = 0; j < pp; ++j){
+        for(int i = 0; i <= j; ++i){
+            double c = 0;
+            for(int k = 0; k < nn; ++k) c += X[i * nn + k] * X[j * nn + k];
+            corvec.push_back(c);
+        }
+    }
+    Matrix<double> cors = cor_vector_to_Matrix(corvec, pp);
+
+    std::vector<int> blockvec;
+    for(int j = 0; j < pp; ++j){
+        for(int i = 0; i < j; ++i){
+            blockvec.push_back(i);
+            blockvec.push_back(j);
+        }
+    }
+    BlockList blocks(blockvec, pp);
+
+    //
+    // Solve at one value of lambda, then keep sweeping from the solution
+    //
+    double lambda = 0.3 * sqrt(nn);
+    std::vector<double> sigmas(pp, -1.);
+    std::vector<double> params = {2.0, 1e-4, 100, 3, 0};
+    SparseMatrix betas(pp);
+    singleCCDr(cors, betas, sigmas, nn, lambda, params, 0, blocks, WorkBudget());
+
+    CCDrAlgorithm alg(100, 1e-4, 3, pp, blocks, false, true, LINF);
+    PenaltyFunction pen(2.0);
+    concaveCDInit(lambda, nn, betas, alg, pen, cors, 0); // warm up
+    concaveCD(lambda, nn, betas, alg, pen, cors, 0);
+
+    unsigned long before = numAllocs;
+    for(int k = 0; k < NUM_SWEEPS; ++k){
+        concaveCDInit(lambda, nn, betas, alg, pen, cors, 0);
+        concaveCD(lambda, nn, betas, alg, pen, cors, 0);
+    }
+    unsigned long sweepAllocs = numAllocs - before;
+
+    printf("%d edges, %d sweeps: %lu heap allocations\n", betas.activeSetSize(), NUM_SWEEPS, sweepAllocs);
+    if(betas.activeSetSize() == 0 || sweepAllocs > 0){
+        printf("FAILED\n");
+        return 1;
+    }
+
+    printf("OK\n");
+    return 0;
+}
@@ -0,0 +1,240 @@
+//
+//  AndersonAccelerator.h
+//  ccdr2
+//
+
+#ifndef AndersonAccelerator_h
+#define AndersonAccelerator_h
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+//------------------------------------------------------------------------------/
+//   ANDERSON ACCELERATOR CLASS
+//------------------------------------------------------------------------------/
+
+//
+// Implements (type-II) Anderson acceleration for a fixed-point iteration x -> G(x). In CCDr, the map G is a
+//   single call to concaveCD, i.e. one full pass of coordinate descent over a FIXED active set, and x is the
+//   vector of coefficients stored in the sparse structure (in column-major order).
+//
+// Given the last m iterates x_k and their images g_k = G(x_k), define the residuals f_k = g_k - x_k. The
+//   extrapolated point is
+//
+//          x_acc = g_k - dG * gamma,  where  gamma = argmin || f_k - dF * gamma ||_2
+//
+//   and the columns of dF (resp. dG) are the successive differences f_{l+1} - f_l (resp. g_{l+1} - g_l) over the
+//   stored history. The small least-squares problem is solved via the normal equations, with a tiny amount of
+//   Tikhonov regularization to keep things stable when the differences are nearly collinear.
+//
+// The accelerator itself knows nothing about the objective: it is up to the caller to check that the extrapolated
+//   point actually decreases the objective, and to call reset() when it does not (see singleCCDr).
+//
+// NOTES:
+//   -depth = 0 disables acceleration entirely (extrapolate() always returns false)
+//   -the history is cleared whenever the length of the coefficient vector changes, which happens whenever the
+//     active set changes
+//   -the history is kept in a ring buffer whose slots (and the small normal equations) are reused from one
+//     iteration to the next, so once the buffers have grown to the size of the active set, extrapolate()
+//     does not allocate
+//
+class AndersonAccelerator{
+
+public:
+    //
+    // Constructors
+    //
+    AndersonAccelerator(unsigned int m);
+
+    //
+    // Member functions
+    //
+    bool enabled() const;                           // returns true if depth > 0
+    bool extrapolate(const std::vector<double>& x,  // attempt to compute an extrapolated point from (x, G(x))
+                     const std::vector<double>& gx,
+                     std::vector<double>& out);
+    void reset();                                   // clear the history (e.g. after a rejected step)
+    void accept();                                  // record that an extrapolated point was accepted
+    void reject();                                  // record that an extrapolated point was rejected (also resets)
+    unsigned int numAccepted() const;
+    unsigned int numRejected() const;
+
+private:
+    unsigned int depth;                         // maximum number of differences to keep in the history
+    std::vector< std::vector<double> > gHist;   // past values of G(x) (ring buffer with depth + 1 slots)
+    std::vector< std::vector<double> > fHist;   // past values of G(x) - x (same layout as gHist)
+    unsigned int head;                          // slot holding the oldest entry
+    unsigned int count;                         // number of entries currently in the history
+    std::vector<double> A, b;                   // normal equations (reused between calls)
+    unsigned int accepted;
+    unsigned int rejected;
+
+    std::vector<double>& g(unsigned int l);     // lth oldest entry of the history
+    std::vector<double>& f(unsigned int l);
+    bool solve(std::vector<double>& A, std::vector<double>& b, unsigned int m) const;
+};
+
+// Explicit constructor
+AndersonAccelerator::AndersonAccelerator(unsigned int m){
+    depth = m;
+    head = 0;
+    count = 0;
+    accepted = 0;
+    rejected = 0;
+
+    if(depth > 0){
+        gHist.resize(depth + 1);
+        fHist.resize(depth + 1);
+    }
+}
+
+std::vector<double>& AndersonAccelerator::g(unsigned int l){
+    return gHist[(head + l) % (depth + 1)];
+}
+
+std::vector<double>& AndersonAccelerator::f(unsigned int l){
+    return fHist[(head + l) % (depth + 1)];
+}
+
+bool AndersonAccelerator::enabled() const{
+    return (depth > 0);
+}
+
+void AndersonAccelerator::reset(){
+    head = 0;
+    count = 0;
+}
+
+void AndersonAccelerator::accept(){
+    accepted++;
+}
+
+void AndersonAccelerator::reject(){
+    rejected++;
+    reset();
+}
+
+unsigned int AndersonAccelerator::numAccepted() const{
+    return accepted;
+}
+
+unsigned int AndersonAccelerator::numRejected() const{
+    return rejected;
+}
+
+//
+// Push (x, G(x)) onto the history and, if there are at least two entries in the history, compute the
+//   extrapolated point and store it in out.
+//
+// Returns true if an extrapolated point was computed, false otherwise (in which case out is untouched)
+//
+bool AndersonAccelerator::extrapolate(const std::vector<double>& x,
+                                      const std::vector<double>& gx,
+                                      std::vector<double>& out){
+    if(depth == 0) return false;
+
+    size_t n = gx.size();
+    if(count > 0 && g(count - 1).size() != n) reset(); // active set has changed: start over
+
+    // push (x, G(x)) onto the history, overwriting the oldest entry if the history is full
+    if(count < depth + 1){
+        count++;
+    } else{
+        head = (head + 1) % (depth + 1);
+    }
+
+    std::vector<double>& gx_k = g(count - 1);
+    std::vector<double>& fx = f(count - 1);
+    gx_k.assign(gx.begin(), gx.end());
+    fx.resize(n);
+    for(size_t i = 0; i < n; ++i) fx[i] = gx[i] - x[i];
+
+    unsigned int m = count - 1; // number of differences available
+    if(m == 0) return false;
+
+    //
+    // Form the normal equations (dF^T dF) gamma = dF^T f_k
+    //   dF[l] = f_{l+1} - f_l, stored implicitly
+    //
+    A.assign(m * m, 0.);
+    b.assign(m, 0.);
+    for(unsigned int l = 0; l < m; ++l){
+        const std::vector<double>& f0 = f(l);
+        const std::vector<double>& f1 = f(l + 1);
+        for(unsigned int r = l; r < m; ++r){
+            const std::vector<double>& f0r = f(r);
+            const std::vector<double>& f1r = f(r + 1);
+            double s = 0.;
+            for(size_t i = 0; i < n; ++i){
+                s += (f1[i] - f0[i]) * (f1r[i] - f0r[i]);
+            }
+            A[l * m + r] = s;
+            A[r * m + l] = s;
+        }
+
+        double s = 0.;
+        for(size_t i = 0; i < n; ++i){
+            s += (f1[i] - f0[i]) * fx[i];
+        }
+        b[l] = s;
+    }
+
+    if(!solve(A, b, m)){
+        reset();
+        return false;
+    }
+
+    // x_acc = g_k - dG * gamma
+    out.assign(gx.begin(), gx.end());
+    for(unsigned int l = 0; l < m; ++l){
+        const std::vector<double>& g0 = g(l);
+        const std::vector<double>& g1 = g(l + 1);
+        for(size_t i = 0; i < n; ++i){
+            out[i] -= (g1[i] - g0[i]) * b[l];
+        }
+    }
+
+    return true;
+}
+
+//
+// Solve the (small, symmetric) system A * gamma = b by Gaussian elimination with partial pivoting; the
+//   solution overwrites b. Returns false if the system is (numerically) singular.
+//
+bool AndersonAccelerator::solve(std::vector<double>& A, std::vector<double>& b, unsigned int m) const{
+    double scale = 0.;
+    for(unsigned int l = 0; l < m; ++l) scale = std::max(scale, A[l * m + l]);
+    if(scale <= 0.) return false;
+
+    for(unsigned int l = 0; l < m; ++l) A[l * m + l] += 1e-10 * scale; // regularize
+
+    for(unsigned int c = 0; c < m; ++c){
+        unsigned int piv = c;
+        for(unsigned int r = c + 1; r < m; ++r){
+            if(fabs(A[r * m + c]) > fabs(A[piv * m + c])) piv = r;
+        }
+        if(fabs(A[piv * m + c]) < 1e-14 * scale) return false;
+
+        if(piv != c){
+            for(unsigned int k = 0; k < m; ++k) std::swap(A[c * m + k], A[piv * m + k]);
+            std::swap(b[c], b[piv]);
+        }
+
+        for(unsigned int r = c + 1; r < m; ++r){
+            double f = A[r * m + c] / A[c * m + c];
+            for(unsigned int k = c; k < m; ++k) A[r * m + k] -= f * A[c * m + k];
+            b[r] -= f * b[c];
+        }
+    }
+
+    for(int c = static_cast<int>(m) - 1; c >= 0; --c){
+        double s = b[c];
+        for(unsigned int k = c + 1; k < m; ++k) s -= A[c * m + k] * b[k];
+        b[c] = s / A[c * m + c];
+    }
+
+    return true;
+}
+
+#endif
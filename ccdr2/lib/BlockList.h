@@ -10,13 +10,37 @@
 #define BlockList_h
 
 #include <vector>
-#include <math.h>
-#include <algorithm>
+#include <memory>
 
 //------------------------------------------------------------------------------/
 //   BLOCKLIST CLASS
 //------------------------------------------------------------------------------/
 
+//
+// Stores the list of candidate edges (row, col) = (i, j) that the CCDr algorithm is allowed to update, in the
+//   order in which they are visited by concaveCDInit.
+//
+// The pairs are stored in a single contiguous array (row_0, col_0, row_1, col_1, ...) that is shared between
+//   copies via a shared_ptr, so copying a BlockList (e.g. into a CCDrAlgorithm object for every value of lambda)
+//   is O(1), and getBlock returns a lightweight Block (two ints) instead of allocating a new vector. The pairs
+//   are never modified after construction: randomize = true permutes the visiting order in CCDrAlgorithm instead
+//   of the list itself.
+//
+
+//
+// Block
+//
+//   A single (row, col) pair; block[0] = row, block[1] = col for compatibility with the old vector interface
+//
+struct Block{
+    int row;
+    int col;
+
+    int operator[](int l) const{
+        return (l == 0) ? row : col;
+    }
+};
+
 class BlockList{
 
 public:
@@ -28,57 +52,76 @@ public:
     // Constructors
     //
     BlockList();
-    BlockList(std::vector<std::vector<int>> in_blocks);
-    BlockList(std::vector<std::vector<int>> in_blocks, unsigned int in_nodes);
+    BlockList(const std::vector<std::vector<int>>& in_blocks);
+    BlockList(const std::vector<std::vector<int>>& in_blocks, unsigned int in_nodes);
+    BlockList(const std::vector<int>& in_pairs, unsigned int in_nodes); // flat (row, col, row, col, ...) input
 
     //
     // Member functions
     //
-    std::vector<int> getBlock(unsigned int k) const;
+    Block getBlock(unsigned int k) const;
     unsigned int size() const;
-    void shuffle();
+    const int* data() const;    // pointer to the flat (row, col, ...) array
 
 private:
-    std::vector<std::vector<int>> blocks;  // [k][l], k<=size, l<=2
+    std::shared_ptr< const std::vector<int> > pairs;    // [2k] = row, [2k+1] = col, k < size
 };
 
 BlockList::BlockList(){
-    std::vector<std::vector<int>> empty;
-    blocks = empty;
-    numBlocks = empty.size();
+    pairs = std::make_shared< std::vector<int> >();
+    numBlocks = 0;
     nodes = 0;
 }
 
-BlockList::BlockList(std::vector<std::vector<int>> in_blocks){
+BlockList::BlockList(const std::vector<std::vector<int>>& in_blocks){
     //
     // Probably add some consistency checks here
     //
 
-    blocks = in_blocks;
-    numBlocks = in_blocks.size();
+    std::shared_ptr< std::vector<int> > flat = std::make_shared< std::vector<int> >(2 * in_blocks.size());
+    for(size_t k = 0; k < in_blocks.size(); ++k){
+        (*flat)[2*k] = in_blocks[k][0];
+        (*flat)[2*k + 1] = in_blocks[k][1];
+    }
+    pairs = flat;
+    numBlocks = static_cast<unsigned int>(in_blocks.size());
     nodes = 0;
 }
 
-BlockList::BlockList(std::vector<std::vector<int>> in_blocks, unsigned int in_nodes){
+BlockList::BlockList(const std::vector<std::vector<int>>& in_blocks, unsigned int in_nodes){
     //
     // Probably add some consistency checks here
     //
 
-    blocks = in_blocks;
-    numBlocks = in_blocks.size();
+    std::shared_ptr< std::vector<int> > flat = std::make_shared< std::vector<int> >(2 * in_blocks.size());
+    for(size_t k = 0; k < in_blocks.size(); ++k){
+        (*flat)[2*k] = in_blocks[k][0];
+        (*flat)[2*k + 1] = in_blocks[k][1];
+    }
+    pairs = flat;
+    numBlocks = static_cast<unsigned int>(in_blocks.size());
     nodes = in_nodes;
 }
 
-std::vector<int> BlockList::getBlock(unsigned int k) const{
-    return blocks[k]; // 2-dimensional vector
+BlockList::BlockList(const std::vector<int>& in_pairs, unsigned int in_nodes){
+    pairs = std::make_shared< std::vector<int> >(in_pairs);
+    numBlocks = static_cast<unsigned int>(in_pairs.size() / 2);
+    nodes = in_nodes;
+}
+
+Block BlockList::getBlock(unsigned int k) const{
+    Block b;
+    b.row = (*pairs)[2*k];
+    b.col = (*pairs)[2*k + 1];
+    return b;
 }
 
 unsigned int BlockList::size() const{
     return numBlocks;
 }
 
-void BlockList::shuffle(){
-    std::random_shuffle(blocks.begin(), blocks.end());
-};
+const int* BlockList::data() const{
+    return pairs->data();
+}
 
 #endif
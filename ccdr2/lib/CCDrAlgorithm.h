@@ -11,12 +11,83 @@
 
 #include <vector>
 #include <math.h>
+#include <algorithm>
+#include <chrono>
 
 #include "BlockList.h"
+#include "CounterRNG.h"
 
 // to keep track of the norm used to compute the error
 enum errtype {L1, LINF};
 
+//
+// Why the algorithm stopped for a given value of lambda. Anything other than STOP_CONVERGED means that the
+//   estimate is only partial: it is a valid (acyclic) estimate, but the parameters have not converged.
+//
+//   STOP_CONVERGED = the active set stopped changing and the updates over it converged to within eps
+//   STOP_MAX_ITERS = maxIters was reached (either full sweeps, or passes over the final active set)
+//   STOP_EDGE_THRESHOLD = the active set grew beyond alpha * pp (gridCCDr stops after this estimate)
+//   STOP_TIME_BUDGET / STOP_PASS_BUDGET / STOP_EVAL_BUDGET = a work budget ran out (see WorkBudget)
+//
+enum stopReason {STOP_CONVERGED, STOP_MAX_ITERS, STOP_EDGE_THRESHOLD, STOP_TIME_BUDGET, STOP_PASS_BUDGET, STOP_EVAL_BUDGET};
+
+const char* stopReasonName(stopReason r){
+    switch(r){
+        case STOP_CONVERGED: return "converged";
+        case STOP_MAX_ITERS: return "max_iters";
+        case STOP_EDGE_THRESHOLD: return "edge_threshold";
+        case STOP_TIME_BUDGET: return "time_budget";
+        case STOP_PASS_BUDGET: return "pass_budget";
+        case STOP_EVAL_BUDGET: return "eval_budget";
+    }
+
+    return "unknown";
+}
+
+//
+// WorkBudget
+//
+//   Limits on the work done for a single value of lambda (or, in gridCCDr, for the whole path). A limit of zero
+//     means no limit. Work is measured in three ways:
+//
+//   seconds = wall-clock time
+//   passes = passes over the parameters (full sweeps and passes over the active set, see getIters)
+//   evals = candidate evaluations, i.e. calls to singleUpdate
+//
+//   The budgets are read from params (see budgetFromParams): params[6..8] = {seconds, passes, evals} per lambda,
+//     params[9..11] = the same for the whole path.
+//
+struct WorkBudget{
+    double seconds;
+    double passes;
+    double evals;
+
+    WorkBudget() : seconds(0), passes(0), evals(0){}
+    bool unlimited() const { return seconds <= 0 && passes <= 0 && evals <= 0; }
+};
+
+WorkBudget budgetFromParams(const std::vector<double>& params, size_t offset){
+    WorkBudget b;
+    if(params.size() > offset) b.seconds = params[offset];
+    if(params.size() > offset + 1) b.passes = params[offset + 1];
+    if(params.size() > offset + 2) b.evals = params[offset + 2];
+
+    return b;
+}
+
+//
+// SolveStatus
+//
+//   Summary of how the algorithm finished for a single value of lambda (returned by singleCCDr)
+//
+struct SolveStatus{
+    unsigned int iters;         // passes over the parameters (see getIters)
+    unsigned int sweeps;        // full sweeps (see addSweep)
+    unsigned long long evals;   // candidate evaluations
+    double error;               // error of the last pass (see getError): how far from converged the estimate is
+    stopReason status;
+};
+
 //------------------------------------------------------------------------------/
 //   CCDR ALGORITHM CLASS
 //------------------------------------------------------------------------------/
@@ -38,6 +109,7 @@ enum errtype {L1, LINF};
 // Other important parameters are tracked automatically:
 //
 //   numSweeps = the total number of sweeps run so far
+//   numIters = the total number of passes (concaveCDInit + concaveCD) run so far
 //   error = the total accumulated error from each single parameter update run so far
 //
 // There is also a vector called 'stopFlags' which is used to keep track of the various reasons for terminating the
@@ -61,6 +133,10 @@ enum errtype {L1, LINF};
 //   keepGoing() checks (3) => model for this lambda is completely finished
 //   moar() checks (2a) and (2b) => model for this active set is finished, but another complete sweep will follow
 //
+// Finally, an optional WorkBudget (see setBudget) stops everything as soon as it runs out, including in the middle
+//   of a pass: both keepGoing() and moar() return false from then on. Checking the budget (outOfBudget) is cheap
+//   enough to do before every candidate evaluation: the clock is only read every BUDGET_CLOCK_INTERVAL calls.
+//
 class CCDrAlgorithm{
 
 public:
@@ -71,7 +147,8 @@ public:
     //
     // Constructors
     //
-    CCDrAlgorithm(unsigned int m, double e, double a, unsigned int p, BlockList b, bool r, bool u, errtype t);
+    CCDrAlgorithm(unsigned int m, double e, double a, unsigned int p, BlockList b, bool r, bool u, errtype t,
+                  CounterRNG g = CounterRNG());
 
     //
     // Member functions
@@ -87,12 +164,38 @@ public:
     void updateError(double e);     // add a value to the error term
     void resetError();              // reset the error term (error) to zero
     void addSweep();                // increment numSweeps
+    void addIter();                 // increment numIters
+    unsigned int getIters() const;  // total number of passes over the parameters run so far
+    unsigned int getSweeps() const; // total number of full sweeps run so far
     void setOrder();                // set the order of the SPUs by either randomizing or leaving as is
     unsigned int numBlocks() const; // number of blocks to iterate over
-    std::vector<int> getBlock(unsigned int k) const; // grab the kth block
+    Block getBlock(unsigned int k) const; // grab the kth block
     void printOrder(); // debugging
     bool updateSigmas();
 
+    //
+    // Sigma cache: the running inner products c_j = sum_i beta_ij * <xj,xi> used to update sigmas
+    //
+    void resetSigmaCache(unsigned int p);     // invalidate the cache: all c_j are recomputed on the next sigma update
+    void invalidateSigmaCache();              // same as above, keeping the current dimension
+    bool sigmaCacheValid() const;             // false => all c_j need to be recomputed from scratch
+    void edgeChanged(unsigned int j, double dc); // column j changed: c_j += dc and flag sigma_j for update
+    bool sigmaChanged(unsigned int j) const;  // has column j changed since sigma_j was last updated?
+    double sigmaInnerProd(unsigned int j) const;  // get c_j
+    void setSigmaInnerProd(unsigned int j, double c); // set c_j and clear the change flag for column j
+    void validateSigmaCache();                // mark the cache as valid once every c_j has been recomputed
+
+    //
+    // Work budget
+    //
+    void setBudget(const WorkBudget& b);      // start the clock and set the limits (an unlimited budget is never checked)
+    void addEval();                           // increment the number of candidate evaluations
+    unsigned long long getEvals() const;      // total number of candidate evaluations so far
+    bool outOfBudget();                       // has the budget run out? (reads the clock only occasionally)
+    bool checkBudget();                       // same, but always reads the clock (use between passes)
+    bool budgetExhausted() const;             // has either of the above returned true?
+    stopReason budgetReason() const;          // which limit ran out
+
 private:
     //
     // This vector keeps track of whether or not to continue iterating the coordinate descent
@@ -107,12 +210,30 @@ private:
 
     // thresholds
     unsigned int numSweeps; // to keep track of how many full sweeps we have performed, including each check of the active set
+    unsigned int numIters;  // to keep track of how many passes (full or active set only) we have performed
     double L1Error;         // to store the L1 error from each iteration of the CCDr algorithm
     double LinfError;       // to store the Linf (maxmimum absolute) error from each iteration of the CCDr algorithm
 
+    // sigma cache (see computeSigmas in algorithm.h)
+    std::vector<double> sigmaC;     // running value of c_j for each column
+    std::vector<bool> sigmaDirty;   // whether or not column j has changed since sigma_j was last computed
+    bool sigmaCacheValid_;          // if false, every c_j must be recomputed from scratch
+
+    // work budget
+    static const unsigned int BUDGET_CLOCK_INTERVAL = 256;
+    WorkBudget budget;
+    bool hasBudget;
+    bool budgetExhausted_;
+    stopReason budgetReason_;
+    unsigned long long numEvals;
+    unsigned int budgetTicks;
+    std::chrono::steady_clock::time_point budgetStart;
+
     // algorithm options
-    BlockList blocks;
+    BlockList blocks;                   // shared with the caller (copying a BlockList does not copy the blocks)
+    std::vector<unsigned int> order;    // if randomizeOrder = true, the kth block visited is blocks[order[k]]
     bool randomizeOrder;
+    CounterRNG rng;                     // owned by this object, so that runs on different threads never share a stream
     bool updateSigmas_;
     errtype errorNorm_;
 };
@@ -125,24 +246,46 @@ CCDrAlgorithm::CCDrAlgorithm(unsigned int m,
                              BlockList b, 
                              bool r,
                              bool u,
-                             errtype t){
+                             errtype t,
+                             CounterRNG g){
     maxIters = m;
     eps = e;
     alpha = a;
     maxEdges = round(a * p);
     blocks = b;
     randomizeOrder = r;
+    rng = g;
     numSweeps = 0;
+    numIters = 0;
     L1Error = 0;
     LinfError = 0;
     stopFlags = std::vector<int>(2, 0);
     updateSigmas_ = u;
     errorNorm_ = t;
+    resetSigmaCache(p);
+    hasBudget = false;
+    budgetExhausted_ = false;
+    budgetReason_ = STOP_CONVERGED;
+    numEvals = 0;
+    budgetTicks = 0;
 }
 
 void CCDrAlgorithm::setOrder(){
+    //
+    // Shuffle an index array instead of the blocks themselves, so that the BlockList can be shared across
+    //  every lambda (and every thread) without copying. This visits the blocks in exactly the same order
+    //  as shuffling the BlockList directly would.
+    //
+    // The random numbers come from rng (see CounterRNG.h) rather than the global rand(), so the order only depends
+    //  on the seed and stream it was given and on the number of shuffles so far.
+    //
     if(randomizeOrder){
-        blocks.shuffle();
+        if(order.size() != blocks.size()){
+            order.resize(blocks.size());
+            for(unsigned int k = 0; k < order.size(); ++k) order[k] = k;
+        }
+
+        rng.shuffle(order);
     }
 
     return;
@@ -151,8 +294,8 @@ void CCDrAlgorithm::setOrder(){
 // mostly for debugging
 void CCDrAlgorithm::printOrder(){
     OUTPUT << std::endl;
-    for(int k = 0; k < blocks.size(); ++k){
-        std::vector<int> bl = blocks.getBlock(k);
+    for(unsigned int k = 0; k < blocks.size(); ++k){
+        Block bl = getBlock(k);
         OUTPUT << "[" << bl[0] << " | " << bl[1] << "]->";
     }
 
@@ -165,8 +308,8 @@ unsigned int CCDrAlgorithm::numBlocks() const{
     return blocks.size();
 }
 
-std::vector<int> CCDrAlgorithm::getBlock(unsigned int k) const{
-    return blocks.getBlock((k)); // 2-dimensional vector
+Block CCDrAlgorithm::getBlock(unsigned int k) const{
+    return blocks.getBlock(randomizeOrder ? order[k] : k);
 }
 
 //
@@ -197,6 +340,9 @@ bool CCDrAlgorithm::keepGoing() const{
     // check if maxIters has been exceeded
     if(numSweeps > maxIters) prod = 0;
 
+    // check if the work budget has run out
+    if(budgetExhausted_) prod = 0;
+
     // if prod = 1, keep going, if prod = 0, stop
     return (prod > 0);
 }
@@ -233,7 +379,7 @@ bool CCDrAlgorithm::moar(int iters) const{
         }
     #endif
 
-    return (error > eps && iters <= maxIters);
+    return (error > eps && iters <= maxIters && !budgetExhausted_);
 }
 
 int CCDrAlgorithm::edgeThreshold() const{
@@ -298,8 +444,123 @@ void CCDrAlgorithm::addSweep(){
     numSweeps++;
 }
 
+void CCDrAlgorithm::addIter(){
+    numIters++;
+}
+
+unsigned int CCDrAlgorithm::getIters() const{
+    return numIters;
+}
+
+unsigned int CCDrAlgorithm::getSweeps() const{
+    return numSweeps;
+}
+
 bool CCDrAlgorithm::updateSigmas(){
     return updateSigmas_;
 }
 
+//
+// Sigma cache
+//
+//   Updating sigma_j requires c_j = sum_i beta_ij * <xj,xi>, which is an O(|pa(j)|) computation. Instead of
+//     recomputing every c_j at the start of every pass, we keep a running value of c_j which is updated each
+//     time an edge in column j changes (see edgeChanged), and only update sigma_j for columns that have actually
+//     changed since the last time sigma_j was computed.
+//
+//   Whenever betas is modified without going through edgeChanged (e.g. at the start of singleCCDr), the cache must
+//     be invalidated so that every c_j is recomputed from scratch.
+//
+void CCDrAlgorithm::resetSigmaCache(unsigned int p){
+    sigmaC.assign(p, 0.);
+    sigmaDirty.assign(p, true);
+    sigmaCacheValid_ = false;
+}
+
+void CCDrAlgorithm::invalidateSigmaCache(){
+    resetSigmaCache(static_cast<unsigned int>(sigmaC.size()));
+}
+
+bool CCDrAlgorithm::sigmaCacheValid() const{
+    return sigmaCacheValid_;
+}
+
+void CCDrAlgorithm::edgeChanged(unsigned int j, double dc){
+    if(dc == 0.) return;
+
+    sigmaC[j] += dc;
+    sigmaDirty[j] = true;
+}
+
+bool CCDrAlgorithm::sigmaChanged(unsigned int j) const{
+    return sigmaDirty[j];
+}
+
+double CCDrAlgorithm::sigmaInnerProd(unsigned int j) const{
+    return sigmaC[j];
+}
+
+void CCDrAlgorithm::setSigmaInnerProd(unsigned int j, double c){
+    sigmaC[j] = c;
+    sigmaDirty[j] = false;
+}
+
+void CCDrAlgorithm::validateSigmaCache(){
+    sigmaCacheValid_ = true;
+}
+
+//
+// Work budget
+//
+void CCDrAlgorithm::setBudget(const WorkBudget& b){
+    budget = b;
+    hasBudget = !b.unlimited();
+    budgetExhausted_ = false;
+    budgetReason_ = STOP_CONVERGED;
+    budgetTicks = 0;
+    budgetStart = std::chrono::steady_clock::now();
+}
+
+void CCDrAlgorithm::addEval(){
+    numEvals++;
+}
+
+unsigned long long CCDrAlgorithm::getEvals() const{
+    return numEvals;
+}
+
+bool CCDrAlgorithm::outOfBudget(){
+    if(!hasBudget) return false;
+    if(budgetExhausted_) return true;
+
+    if(budget.evals > 0 && numEvals >= budget.evals){
+        budgetExhausted_ = true;
+        budgetReason_ = STOP_EVAL_BUDGET;
+    } else if(budget.passes > 0 && numIters >= budget.passes){
+        budgetExhausted_ = true;
+        budgetReason_ = STOP_PASS_BUDGET;
+    } else if(budget.seconds > 0 && ++budgetTicks >= BUDGET_CLOCK_INTERVAL){
+        budgetTicks = 0;
+        if(std::chrono::duration<double>(std::chrono::steady_clock::now() - budgetStart).count() >= budget.seconds){
+            budgetExhausted_ = true;
+            budgetReason_ = STOP_TIME_BUDGET;
+        }
+    }
+
+    return budgetExhausted_;
+}
+
+bool CCDrAlgorithm::checkBudget(){
+    if(hasBudget) budgetTicks = BUDGET_CLOCK_INTERVAL;
+    return outOfBudget();
+}
+
+bool CCDrAlgorithm::budgetExhausted() const{
+    return budgetExhausted_;
+}
+
+stopReason CCDrAlgorithm::budgetReason() const{
+    return budgetReason_;
+}
+
 #endif
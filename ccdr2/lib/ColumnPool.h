@@ -0,0 +1,240 @@
+//
+//  ColumnPool.h
+//  ccdr2
+//
+
+#ifndef ColumnPool_h
+#define ColumnPool_h
+
+#include <vector>
+#include <new>
+#include <cstddef>
+#include <atomic>
+
+//------------------------------------------------------------------------------/
+//   COLUMN POOL
+//------------------------------------------------------------------------------/
+
+//
+// A simple pooled allocator for the per-column storage of SparseMatrix (rows / vals / blocks).
+//
+// Over the course of a solution path the algorithm repeatedly grows columns (addEdge), copies whole matrices
+//   (once per lambda) and destroys them again, so the same handful of buffer sizes is requested from malloc over
+//   and over. Once several fits run in the same process (e.g. in parallel), this traffic all goes through the
+//   global allocator and becomes a point of contention.
+//
+// Instead, freed column buffers are kept on a free list and handed out again on the next request of the same
+//   size class (powers of two, from 16 bytes up to 2^(NUM_SIZE_CLASSES + 3) bytes). Each thread has its own pool,
+//   so no locking is required; a buffer allocated by one thread and freed by another simply moves to the second
+//   thread's pool. Larger buffers, and buffers beyond the per-thread cache limit, go straight to the system.
+//
+// After the first lambda or so, every column buffer the algorithm needs is served from the pool, so the sweeps
+//   themselves do not touch the system allocator at all: see stats(), which counts the requests that had to be
+//   passed on to the system, and alloctest.cpp, which checks that repeated sweeps make no heap allocations.
+//
+// The cached memory is bounded and does not outlive a run:
+//   -each thread caches at most cacheLimit() bytes (DEFAULT_CACHE_LIMIT unless changed with setCacheLimit). This
+//     also bounds the buffers that pile up on a thread which frees more than it allocates (e.g. the thread that
+//     collects the results of the others)
+//   -releaseAll() asks every thread to return its cache to the system: the calling thread does so at once, the
+//     others at their next allocation, or as soon as they are idle for the workers of the shared thread pool (see
+//     ThreadPool::releaseColumnCaches, which is called at the end of every run started from R)
+//   -a thread's cache is also returned when the thread exits, e.g. when the thread pool is replaced
+//
+
+struct ColumnPoolStats{
+    unsigned long systemAllocs;     // number of requests that went to the system allocator
+    unsigned long poolHits;         // number of requests served from the free lists
+    unsigned long cachedBytes;      // bytes currently held on the free lists
+};
+
+class ColumnPool{
+
+public:
+    //
+    // Constructors
+    //
+    ColumnPool();
+    ~ColumnPool();
+
+    //
+    // Member functions
+    //
+    static ColumnPool& local();                 // the pool for the calling thread
+    void* allocate(std::size_t bytes);
+    void deallocate(void* p, std::size_t bytes);
+    ColumnPoolStats stats() const;
+    void release();                             // return every cached buffer to the system
+    bool stale() const;                         // has releaseAll() been called since this pool was last released?
+    void releaseIfStale();
+
+    static void releaseAll();                   // ask every thread to release its pool (see above)
+    static void setCacheLimit(std::size_t bytes);   // per-thread limit on the size of the free lists (0 = no caching)
+    static std::size_t cacheLimit();
+
+    static const std::size_t DEFAULT_CACHE_LIMIT = 4 << 20;
+
+private:
+    static const int NUM_SIZE_CLASSES = 24;     // 16B ... 128MB
+
+    struct FreeBlock{ FreeBlock* next; };       // free buffers are chained through their first bytes
+
+    FreeBlock* freeLists[NUM_SIZE_CLASSES];
+    ColumnPoolStats stats_;
+    unsigned long epoch_;                       // value of releaseEpoch() when this pool was last released
+
+    static int sizeClass(std::size_t bytes);    // -1 if too large to pool
+    static std::atomic<unsigned long>& releaseEpoch();
+    static std::atomic<std::size_t>& limitSetting();
+
+    ColumnPool(const ColumnPool&);              // not copyable
+    ColumnPool& operator=(const ColumnPool&);
+};
+
+ColumnPool::ColumnPool(){
+    for(int c = 0; c < NUM_SIZE_CLASSES; ++c) freeLists[c] = NULL;
+    stats_.systemAllocs = 0;
+    stats_.poolHits = 0;
+    stats_.cachedBytes = 0;
+    epoch_ = releaseEpoch().load(std::memory_order_relaxed);
+}
+
+ColumnPool::~ColumnPool(){
+    release();
+}
+
+ColumnPool& ColumnPool::local(){
+    static thread_local ColumnPool pool;
+    return pool;
+}
+
+std::atomic<unsigned long>& ColumnPool::releaseEpoch(){
+    static std::atomic<unsigned long> epoch(0);
+    return epoch;
+}
+
+std::atomic<std::size_t>& ColumnPool::limitSetting(){
+    static std::atomic<std::size_t> limit(DEFAULT_CACHE_LIMIT);
+    return limit;
+}
+
+int ColumnPool::sizeClass(std::size_t bytes){
+    int c = 0;
+    std::size_t cap = 16;
+    while(cap < bytes){
+        cap <<= 1;
+        ++c;
+    }
+
+    return (c < NUM_SIZE_CLASSES) ? c : -1;
+}
+
+void* ColumnPool::allocate(std::size_t bytes){
+    releaseIfStale();
+
+    int c = sizeClass(bytes);
+    if(c < 0){
+        stats_.systemAllocs++;
+        return ::operator new(bytes);
+    }
+
+    FreeBlock* head = freeLists[c];
+    if(head != NULL){
+        freeLists[c] = head->next;
+        stats_.poolHits++;
+        stats_.cachedBytes -= (std::size_t(16) << c);
+        return head;
+    }
+
+    stats_.systemAllocs++;
+    return ::operator new(std::size_t(16) << c);
+}
+
+void ColumnPool::deallocate(void* p, std::size_t bytes){
+    if(p == NULL) return;
+    releaseIfStale();
+
+    int c = sizeClass(bytes);
+    if(c < 0 || stats_.cachedBytes + (std::size_t(16) << c) > cacheLimit()){
+        ::operator delete(p);
+        return;
+    }
+
+    FreeBlock* block = static_cast<FreeBlock*>(p);
+    block->next = freeLists[c];
+    freeLists[c] = block;
+    stats_.cachedBytes += (std::size_t(16) << c);
+}
+
+ColumnPoolStats ColumnPool::stats() const{
+    return stats_;
+}
+
+void ColumnPool::release(){
+    for(int c = 0; c < NUM_SIZE_CLASSES; ++c){
+        while(freeLists[c] != NULL){
+            FreeBlock* next = freeLists[c]->next;
+            ::operator delete(freeLists[c]);
+            freeLists[c] = next;
+        }
+    }
+    stats_.cachedBytes = 0;
+    epoch_ = releaseEpoch().load(std::memory_order_relaxed);
+}
+
+bool ColumnPool::stale() const{
+    return epoch_ != releaseEpoch().load(std::memory_order_relaxed);
+}
+
+void ColumnPool::releaseIfStale(){
+    if(stale()) release();
+}
+
+void ColumnPool::releaseAll(){
+    releaseEpoch()++;
+    local().release();
+}
+
+// Changing the limit releases every pool, so that no thread keeps more than the new limit
+void ColumnPool::setCacheLimit(std::size_t bytes){
+    limitSetting() = bytes;
+    releaseAll();
+}
+
+std::size_t ColumnPool::cacheLimit(){
+    return limitSetting().load(std::memory_order_relaxed);
+}
+
+//
+// PoolAllocator
+//
+//   Minimal (C++11) allocator that routes std::vector storage through the thread's ColumnPool
+//
+template<class T>
+class PoolAllocator{
+
+public:
+    typedef T value_type;
+
+    PoolAllocator(){}
+    template<class U> PoolAllocator(const PoolAllocator<U>&){}
+
+    T* allocate(std::size_t n){
+        return static_cast<T*>(ColumnPool::local().allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n){
+        ColumnPool::local().deallocate(p, n * sizeof(T));
+    }
+};
+
+template<class T, class U> bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&){ return true; }
+template<class T, class U> bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&){ return false; }
+
+//
+// Column storage types used by SparseMatrix
+//
+typedef std::vector<int, PoolAllocator<int> > IntColumn;
+typedef std::vector<double, PoolAllocator<double> > DoubleColumn;
+
+#endif
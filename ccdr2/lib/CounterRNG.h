@@ -0,0 +1,111 @@
+//
+//  CounterRNG.h
+//  ccdr2
+//
+
+#ifndef CounterRNG_h
+#define CounterRNG_h
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------/
+//   COUNTER-BASED RANDOM NUMBERS
+//------------------------------------------------------------------------------/
+
+//
+// A counter-based random number generator: the kth number of a stream is a fixed function of (seed, stream, k),
+//   with no other hidden state. This is what makes randomized runs reproducible no matter how the work is split
+//   between threads: every value of lambda (or component, or ensemble copy, ...) gets its own stream, so the numbers
+//   it draws do not depend on what else has run before it, or at the same time on another thread.
+//
+// The mixing function is the SplitMix64 finalizer, applied to a key derived from (seed, stream) plus the counter
+//   times an odd constant; for a fixed key this is a bijection of the counter, so a stream never repeats itself
+//   within 2^64 draws.
+//
+// NOTES:
+//   -the numbers are the same on every platform (no use of rand(), std::random_shuffle or the <random>
+//     distributions, whose output is implementation-defined)
+//   -streams are cheap: a CounterRNG is three integers, and creating one does no work beyond two mixes
+//
+
+class CounterRNG{
+
+public:
+    CounterRNG(uint64_t in_seed = 0, uint64_t in_stream = 0);
+
+    //
+    // Member functions
+    //
+    uint64_t next();                                    // next number of the stream (uniform over 64 bits)
+    uint64_t bounded(uint64_t n);                       // uniform over 0, ..., n-1 (n > 0), without modulo bias
+    template<class T> void shuffle(std::vector<T>& v);  // uniformly random permutation (Fisher-Yates)
+
+    uint64_t seed() const;
+    uint64_t stream() const;
+    uint64_t counter() const;                           // number of draws so far
+    void setCounter(uint64_t c);                        // jump to any position in the stream
+
+private:
+    static uint64_t mix(uint64_t x);
+
+    uint64_t seed_;
+    uint64_t stream_;
+    uint64_t key;
+    uint64_t counter_;
+};
+
+const uint64_t RNG_GOLDEN_GAMMA = 0x9E3779B97F4A7C15ULL;
+
+CounterRNG::CounterRNG(uint64_t in_seed, uint64_t in_stream){
+    seed_ = in_seed;
+    stream_ = in_stream;
+    key = mix(seed_ ^ mix(stream_ + RNG_GOLDEN_GAMMA));
+    counter_ = 0;
+}
+
+uint64_t CounterRNG::mix(uint64_t x){
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+uint64_t CounterRNG::next(){
+    return mix(key + (counter_++ + 1) * RNG_GOLDEN_GAMMA);
+}
+
+uint64_t CounterRNG::bounded(uint64_t n){
+    // reject the lowest (2^64 mod n) values, so that every residue is equally likely
+    uint64_t threshold = (0 - n) % n;
+    for(;;){
+        uint64_t r = next();
+        if(r >= threshold) return r % n;
+    }
+}
+
+template<class T>
+void CounterRNG::shuffle(std::vector<T>& v){
+    for(size_t k = v.size(); k > 1; --k){
+        size_t r = static_cast<size_t>(bounded(k));
+        std::swap(v[k - 1], v[r]);
+    }
+}
+
+uint64_t CounterRNG::seed() const{
+    return seed_;
+}
+
+uint64_t CounterRNG::stream() const{
+    return stream_;
+}
+
+uint64_t CounterRNG::counter() const{
+    return counter_;
+}
+
+void CounterRNG::setCounter(uint64_t c){
+    counter_ = c;
+}
+
+#endif
@@ -0,0 +1,187 @@
+//
+//  EdgeArrays.h
+//  ccdr2
+//
+
+#ifndef EdgeArrays_h
+#define EdgeArrays_h
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cmath>
+
+#include "SparseMatrix.h"
+#include "SolutionPath.h"
+#include "PathSink.h"
+
+//------------------------------------------------------------------------------/
+//   COMPACT EDGE OUTPUT
+//------------------------------------------------------------------------------/
+
+//
+// Flat arrays holding the nonzero edges of one or more estimates, for handing results to R (or anything else)
+//   without going through one vector per node per estimate.
+//
+// The estimates are concatenated: the edges of the lth estimate are entries [offsets[l], offsets[l+1]) of rows /
+//   cols / vals, and its sigmas are entries [l*pp, (l+1)*pp) of sigmas. Within each estimate, edges are sorted by
+//   column (child), then by row (parent). Zero-valued entries (see ZERO_THRESH) are dropped, so nedges[l] is the
+//   actual number of edges.
+//
+// Two layouts:
+//   -EDGES_TRIPLET: (rows[k], cols[k], vals[k]) for each edge k
+//   -EDGES_CSC: cols is empty; instead colptr holds pp + 1 entries per estimate, and the parents of node j in the
+//      lth estimate are entries [offsets[l] + colptr[l*(pp+1) + j], offsets[l] + colptr[l*(pp+1) + j + 1])
+//
+// NOTES:
+//   -base (0 or 1) is added to every node index (rows and cols), so that R can use 1-based indices directly;
+//     offsets and colptr are always 0-based positions
+//
+enum edgeFormat {EDGES_TRIPLET, EDGES_CSC};
+
+struct EdgeArrays{
+    int pp;                         // number of nodes
+    int base;                       // first node index (0 or 1)
+    edgeFormat format;
+
+    std::vector<double> lambdas;    // one per estimate
+    std::vector<int> nedges;        // one per estimate
+    std::vector<size_t> offsets;    // one more than the number of estimates
+    std::vector<int> rows;          // parent of each edge
+    std::vector<int> cols;          // child of each edge (EDGES_TRIPLET only)
+    std::vector<int> colptr;        // pp + 1 per estimate (EDGES_CSC only)
+    std::vector<double> vals;       // weight of each edge
+    std::vector<double> sigmas;     // pp per estimate
+
+    EdgeArrays(int pp_, edgeFormat format_, int base_);
+
+    size_t size() const;            // number of estimates
+    void append(const SparseMatrix& betas, double lambda);
+    void append(const SolutionPath& path, size_t l);
+
+private:
+    std::vector< std::pair<int, double> > scratch;
+
+    template<class Column, class Sigma>
+    void appendEstimate(double lambda, Column column, Sigma sigma);
+};
+
+EdgeArrays::EdgeArrays(int pp_, edgeFormat format_, int base_){
+    pp = pp_;
+    format = format_;
+    base = base_;
+    offsets.push_back(0);
+}
+
+size_t EdgeArrays::size() const{
+    return lambdas.size();
+}
+
+//
+// column(j, n) returns the row and value arrays of column j and sets n to their length
+//
+template<class Column, class Sigma>
+void EdgeArrays::appendEstimate(double lambda, Column column, Sigma sigma){
+    size_t start = rows.size();
+
+    for(int j = 0; j < pp; ++j){
+        if(format == EDGES_CSC) colptr.push_back(static_cast<int>(rows.size() - start));
+
+        int n = 0;
+        std::pair<const int*, const double*> col = column(j, n);
+
+        // the parents are stored in the order they were added: sort them (only the nonzero ones)
+        scratch.clear();
+        for(int k = 0; k < n; ++k){
+            if(fabs(col.second[k]) > ZERO_THRESH) scratch.push_back(std::make_pair(col.first[k], col.second[k]));
+        }
+        std::sort(scratch.begin(), scratch.end());
+
+        for(size_t k = 0; k < scratch.size(); ++k){
+            rows.push_back(scratch[k].first + base);
+            if(format == EDGES_TRIPLET) cols.push_back(j + base);
+            vals.push_back(scratch[k].second);
+        }
+
+        sigmas.push_back(sigma(j));
+    }
+    if(format == EDGES_CSC) colptr.push_back(static_cast<int>(rows.size() - start));
+
+    lambdas.push_back(lambda);
+    nedges.push_back(static_cast<int>(rows.size() - start));
+    offsets.push_back(rows.size());
+}
+
+void EdgeArrays::append(const SparseMatrix& betas, double lambda){
+    appendEstimate(lambda,
+                   [&betas](int j, int& n){ n = betas.rowsizes(j); return std::make_pair(betas.rowptr(j), betas.valptr(j)); },
+                   [&betas](int j){ return betas.sigma(j); });
+}
+
+void EdgeArrays::append(const SolutionPath& path, size_t l){
+    appendEstimate(path.lambda(l),
+                   [&path, l](int j, int& n){ n = path.rowsizes(l, j); return std::make_pair(path.rowptr(l, j), path.valptr(l, j)); },
+                   [&path, l](int j){ return path.sigma(l, j); });
+}
+
+//
+// edgeArrays
+//
+//   Build the flat arrays for a single estimate, or for a whole stored path
+//
+EdgeArrays edgeArrays(const SparseMatrix& betas, double lambda, edgeFormat format, int base){
+    EdgeArrays out(betas.dim(), format, base);
+    out.append(betas, lambda);
+
+    return out;
+}
+
+EdgeArrays edgeArrays(const SolutionPath& path, edgeFormat format, int base){
+    EdgeArrays out(path.dim(), format, base);
+    for(size_t l = 0; l < path.size(); ++l){
+        out.append(path, l);
+    }
+
+    return out;
+}
+
+//
+// EdgeArrayPathSink
+//
+//   Append each estimate to an EdgeArrays as soon as it is computed, so that a path can be returned in the compact
+//     form without ever being stored as SparseMatrix / SolutionPath objects. Stats are kept for every value of lambda.
+//
+class EdgeArrayPathSink : public PathSink{
+
+public:
+    EdgeArrayPathSink(int pp, edgeFormat format, int base);
+
+    void consume(const SparseMatrix& betas, const LambdaStats& stats);
+
+    EdgeArrays& edges();
+    const std::vector<LambdaStats>& stats() const;
+
+private:
+    EdgeArrays edges_;
+    std::vector<LambdaStats> stats_;
+};
+
+EdgeArrayPathSink::EdgeArrayPathSink(int pp, edgeFormat format, int base)
+: edges_(pp, format, base)
+{
+}
+
+void EdgeArrayPathSink::consume(const SparseMatrix& betas, const LambdaStats& stats){
+    edges_.append(betas, stats.lambda);
+    stats_.push_back(stats);
+}
+
+EdgeArrays& EdgeArrayPathSink::edges(){
+    return edges_;
+}
+
+const std::vector<LambdaStats>& EdgeArrayPathSink::stats() const{
+    return stats_;
+}
+
+#endif
@@ -0,0 +1,244 @@
+//
+//  PathSink.h
+//  ccdr2
+//
+
+#ifndef PathSink_h
+#define PathSink_h
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <fstream>
+#include <iomanip>
+#include <functional>
+
+#include "SparseMatrix.h"
+#include "SolutionPath.h"
+#include "CCDrAlgorithm.h"
+
+//------------------------------------------------------------------------------/
+//   PATH SINKS
+//------------------------------------------------------------------------------/
+
+//
+// A PathSink receives the estimates computed by gridCCDr one at a time, as soon as each value of lambda is
+//   finished, instead of all at once at the end of the path. The sink decides what to keep: this makes it possible
+//   to run long paths in bounded memory (LastKPathSink, FilePathSink) and to start working on the early estimates
+//   while the later ones are still being computed (CallbackPathSink).
+//
+// The estimate passed to consume() is the solver's working copy, which is overwritten as soon as consume()
+//   returns: a sink that wants to keep it must copy it.
+//
+// Stock sinks:
+//   -MemoryPathSink: keep the whole path in memory (as a SolutionPath); this is what gridCCDr uses
+//   -LastKPathSink: keep only the K most recent estimates
+//   -FilePathSink: write each estimate to a text file and keep nothing
+//   -CallbackPathSink: pass each estimate to a user-supplied function
+//
+
+//
+// LambdaStats
+//
+//   Summary of the work done for a single value of lambda
+//
+struct LambdaStats{
+    int index;              // position of lambda in the grid
+    double lambda;          // value of lambda
+    double seconds;         // wall-clock time spent on this value of lambda
+    unsigned int iters;     // number of passes over the parameters (see CCDrAlgorithm::getIters)
+    int nedges;             // number of nonzero edges in the estimate
+    unsigned int sweeps;    // number of full sweeps
+    unsigned long long evals; // number of candidate evaluations
+    double error;           // error of the last pass (see CCDrAlgorithm::getError)
+    stopReason status;      // anything other than STOP_CONVERGED means a partial estimate (see CCDrAlgorithm.h)
+};
+
+class PathSink{
+
+public:
+    virtual ~PathSink(){}
+
+    virtual void consume(const SparseMatrix& betas, const LambdaStats& stats) = 0;  // called after each lambda
+    virtual void finish(){}                                                         // called once the path is done
+};
+
+//
+// MemoryPathSink
+//
+//   Keep every estimate in memory (with unchanged columns shared, see SolutionPath.h)
+//
+class MemoryPathSink : public PathSink{
+
+public:
+    void consume(const SparseMatrix& betas, const LambdaStats& stats);
+
+    SolutionPath& path();
+    const std::vector<LambdaStats>& stats() const;
+
+private:
+    SolutionPath path_;
+    std::vector<LambdaStats> stats_;
+};
+
+void MemoryPathSink::consume(const SparseMatrix& betas, const LambdaStats& stats){
+    path_.push_back(betas, stats.lambda);
+    stats_.push_back(stats);
+}
+
+SolutionPath& MemoryPathSink::path(){
+    return path_;
+}
+
+const std::vector<LambdaStats>& MemoryPathSink::stats() const{
+    return stats_;
+}
+
+//
+// LastKPathSink
+//
+//   Keep only the K most recent estimates (e.g. K = 1 to keep only the final estimate); stats are kept for every
+//     value of lambda since they are tiny
+//
+class LastKPathSink : public PathSink{
+
+public:
+    LastKPathSink(unsigned int k);
+
+    void consume(const SparseMatrix& betas, const LambdaStats& stats);
+
+    size_t size() const;                                // number of estimates currently kept (<= K)
+    const SparseMatrix& estimate(size_t k) const;       // kth kept estimate, oldest first
+    const LambdaStats& estimateStats(size_t k) const;   // stats for the kth kept estimate
+    const std::vector<LambdaStats>& stats() const;      // stats for every value of lambda seen so far
+
+private:
+    unsigned int K;
+    std::deque<SparseMatrix> kept;
+    std::deque<LambdaStats> keptStats;
+    std::vector<LambdaStats> stats_;
+};
+
+LastKPathSink::LastKPathSink(unsigned int k){
+    K = k;
+}
+
+void LastKPathSink::consume(const SparseMatrix& betas, const LambdaStats& stats){
+    stats_.push_back(stats);
+    if(K == 0) return;
+
+    if(kept.size() == K){
+        kept.pop_front();
+        keptStats.pop_front();
+    }
+
+    kept.push_back(betas);
+    kept.back().clearBlocks(); // not needed for storage (see SparseMatrix::clearBlocks)
+    keptStats.push_back(stats);
+}
+
+size_t LastKPathSink::size() const{
+    return kept.size();
+}
+
+const SparseMatrix& LastKPathSink::estimate(size_t k) const{
+    return kept[k];
+}
+
+const LambdaStats& LastKPathSink::estimateStats(size_t k) const{
+    return keptStats[k];
+}
+
+const std::vector<LambdaStats>& LastKPathSink::stats() const{
+    return stats_;
+}
+
+//
+// FilePathSink
+//
+//   Append each estimate to a text file as soon as it is computed. Each estimate is written as
+//
+//      lambda <index> <lambda> <nedges> <seconds> <iters> <sweeps> <evals> <error> <status>
+//      sigmas <sigma_0> ... <sigma_{p-1}>
+//      <row> <col> <value>         (one line per nonzero edge)
+//      end
+//
+//   and the file is flushed after every estimate, so that it can be read while the path is still running.
+//
+class FilePathSink : public PathSink{
+
+public:
+    FilePathSink(const std::string& file_name);
+
+    void consume(const SparseMatrix& betas, const LambdaStats& stats);
+    void finish();
+    bool good() const;      // false if the file could not be opened (or a write failed)
+
+private:
+    std::ofstream out;
+};
+
+FilePathSink::FilePathSink(const std::string& file_name){
+    out.open(file_name.c_str());
+    if(!out){
+        ERROR_OUTPUT << "FilePathSink: Could not open " << file_name << " for writing." << std::endl;
+    }
+    out << std::setprecision(17);
+}
+
+void FilePathSink::consume(const SparseMatrix& betas, const LambdaStats& stats){
+    if(!out) return;
+
+    out << "lambda " << stats.index << " " << stats.lambda << " " << stats.nedges << " " << stats.seconds << " " << stats.iters
+        << " " << stats.sweeps << " " << stats.evals << " " << stats.error << " " << stopReasonName(stats.status) << "\n";
+
+    out << "sigmas";
+    for(int j = 0; j < betas.dim(); ++j) out << " " << betas.sigma(j);
+    out << "\n";
+
+    for(int j = 0; j < betas.dim(); ++j){
+        for(int k = 0; k < betas.rowsizes(j); ++k){
+            if(fabs(betas.value(j, k)) > ZERO_THRESH){
+                out << betas.row(j, k) << " " << j << " " << betas.value(j, k) << "\n";
+            }
+        }
+    }
+
+    out << "end" << std::endl; // flush so that finished estimates are visible immediately
+}
+
+void FilePathSink::finish(){
+    out.close();
+}
+
+bool FilePathSink::good() const{
+    return static_cast<bool>(out);
+}
+
+//
+// CallbackPathSink
+//
+//   Forward each estimate to an arbitrary function
+//
+class CallbackPathSink : public PathSink{
+
+public:
+    typedef std::function<void(const SparseMatrix&, const LambdaStats&)> Callback;
+
+    CallbackPathSink(Callback f);
+
+    void consume(const SparseMatrix& betas, const LambdaStats& stats);
+
+private:
+    Callback callback;
+};
+
+CallbackPathSink::CallbackPathSink(Callback f){
+    callback = f;
+}
+
+void CallbackPathSink::consume(const SparseMatrix& betas, const LambdaStats& stats){
+    callback(betas, stats);
+}
+
+#endif
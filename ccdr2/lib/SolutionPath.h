@@ -0,0 +1,205 @@
+//
+//  SolutionPath.h
+//  ccdr2
+//
+
+#ifndef SolutionPath_h
+#define SolutionPath_h
+
+#include <vector>
+#include <memory>
+#include <cstring>
+
+#include "ColumnPool.h"
+#include "SparseMatrix.h"
+
+//------------------------------------------------------------------------------/
+//   SOLUTION PATH CLASS
+//------------------------------------------------------------------------------/
+
+//
+// Stores the sequence of estimates produced by gridCCDr (one per value of lambda) without storing a full copy of
+//   every estimate.
+//
+// Each estimate is stored as a vector of pointers to its columns, and a column is shared (copy-on-write) with the
+//   previous estimate whenever it is exactly the same, i.e. has the same parents in the same order with the same
+//   values. Along a path, most nodes have no parents for most values of lambda and most of the remaining columns
+//   only change when an edge is added nearby, so in practice only a small fraction of the columns is stored for
+//   each new estimate. All empty columns share a single object.
+//
+// Since every estimate keeps its own column pointers, access to any estimate is O(1) (there is no chain of deltas
+//   to replay):
+//   -rowsizes / rowptr / valptr / sigma give read-only access to the stored columns directly
+//   -materialize(l) builds an ordinary SparseMatrix for the lth estimate on demand
+//
+// NOTES:
+//   -the sibling indices (blocks) are not stored, since gridCCDr clears them anyway
+//   -activeSetSize() of a materialized estimate is the actual number of nonzero edges
+//
+class SolutionPath{
+
+public:
+    //
+    // Constructors
+    //
+    SolutionPath();
+
+    //
+    // Member functions
+    //
+    void push_back(const SparseMatrix& betas, double lambda);   // append an estimate, sharing unchanged columns
+    size_t size() const;                                        // number of estimates in the path
+    bool empty() const;
+    int dim() const;                                            // number of nodes
+    double lambda(size_t l) const;                              // value of lambda for the lth estimate
+    int activeSetSize(size_t l) const;                          // number of nonzero edges in the lth estimate
+    int rowsizes(size_t l, int j) const;                        // number of (stored) parents of node j in the lth estimate
+    const int* rowptr(size_t l, int j) const;                   // row indices of column j in the lth estimate
+    const double* valptr(size_t l, int j) const;                // values of column j in the lth estimate
+    double sigma(size_t l, int j) const;                        // sigma_j in the lth estimate
+    SparseMatrix materialize(size_t l) const;                   // build the full lth estimate
+    std::vector<SparseMatrix> materializeAll() const;           // build every estimate (same output as the old gridCCDr)
+    size_t storedColumns() const;                               // number of distinct column objects stored across the path
+    bool sharedWithPrevious(size_t l, int j) const;             // is column j of the lth estimate the same object as in the (l-1)th?
+
+private:
+    struct Column{
+        IntColumn rows;
+        DoubleColumn vals;
+        int nonzero;                                            // number of nonzero values
+    };
+    typedef std::shared_ptr<const Column> ColumnPtr;
+
+    struct Estimate{
+        double lambda;
+        int activeSetLength;
+        std::vector<ColumnPtr> cols;
+        std::vector<double> sigmas;
+    };
+
+    std::vector<Estimate> estimates;
+    ColumnPtr emptyColumn;                                      // shared by every empty column
+    size_t numStored;
+
+    static bool sameColumn(const Column& c, const SparseMatrix& betas, int j);
+};
+
+SolutionPath::SolutionPath(){
+    std::shared_ptr<Column> empty = std::make_shared<Column>();
+    empty->nonzero = 0;
+    emptyColumn = empty;
+    numStored = 1;
+}
+
+// Is column j of betas identical to c?
+bool SolutionPath::sameColumn(const Column& c, const SparseMatrix& betas, int j){
+    size_t n = betas.rowsizes(j);
+    if(c.rows.size() != n) return false;
+    if(n == 0) return true;
+
+    return std::memcmp(c.rows.data(), betas.rowptr(j), n * sizeof(int)) == 0
+        && std::memcmp(c.vals.data(), betas.valptr(j), n * sizeof(double)) == 0;
+}
+
+void SolutionPath::push_back(const SparseMatrix& betas, double lambda){
+    int pp = betas.dim();
+    const Estimate* prev = estimates.empty() ? NULL : &estimates.back();
+
+    Estimate est;
+    est.lambda = lambda;
+    est.activeSetLength = 0;
+    est.cols.resize(pp);
+    est.sigmas.resize(pp);
+
+    for(int j = 0; j < pp; ++j){
+        est.sigmas[j] = betas.sigma(j);
+
+        if(betas.rowsizes(j) == 0){
+            est.cols[j] = emptyColumn;
+        } else if(prev != NULL && sameColumn(*prev->cols[j], betas, j)){
+            est.cols[j] = prev->cols[j]; // unchanged: share with the previous estimate
+        } else{
+            std::shared_ptr<Column> col = std::make_shared<Column>();
+            col->rows.assign(betas.rowptr(j), betas.rowptr(j) + betas.rowsizes(j));
+            col->vals.assign(betas.valptr(j), betas.valptr(j) + betas.rowsizes(j));
+            col->nonzero = betas.recomputeNeighbourhoodSize(j);
+            est.cols[j] = col;
+            numStored++;
+        }
+
+        est.activeSetLength += est.cols[j]->nonzero;
+    }
+
+    estimates.push_back(std::move(est));
+}
+
+size_t SolutionPath::size() const{
+    return estimates.size();
+}
+
+bool SolutionPath::empty() const{
+    return estimates.empty();
+}
+
+int SolutionPath::dim() const{
+    return estimates.empty() ? 0 : static_cast<int>(estimates[0].cols.size());
+}
+
+double SolutionPath::lambda(size_t l) const{
+    return estimates[l].lambda;
+}
+
+int SolutionPath::activeSetSize(size_t l) const{
+    return estimates[l].activeSetLength;
+}
+
+int SolutionPath::rowsizes(size_t l, int j) const{
+    return static_cast<int>(estimates[l].cols[j]->rows.size());
+}
+
+const int* SolutionPath::rowptr(size_t l, int j) const{
+    return estimates[l].cols[j]->rows.data();
+}
+
+const double* SolutionPath::valptr(size_t l, int j) const{
+    return estimates[l].cols[j]->vals.data();
+}
+
+double SolutionPath::sigma(size_t l, int j) const{
+    return estimates[l].sigmas[j];
+}
+
+SparseMatrix SolutionPath::materialize(size_t l) const{
+    const Estimate& est = estimates[l];
+    int pp = static_cast<int>(est.cols.size());
+
+    SparseMatrix out(pp);
+    for(int j = 0; j < pp; ++j){
+        const Column& c = *est.cols[j];
+        out.setColumn(j, c.rows.data(), c.vals.data(), static_cast<int>(c.rows.size()));
+        out.setSigma(j, est.sigmas[j]);
+    }
+    out.clearBlocks();
+
+    return out;
+}
+
+std::vector<SparseMatrix> SolutionPath::materializeAll() const{
+    std::vector<SparseMatrix> out;
+    out.reserve(estimates.size());
+    for(size_t l = 0; l < estimates.size(); ++l){
+        out.push_back(materialize(l));
+    }
+
+    return out;
+}
+
+size_t SolutionPath::storedColumns() const{
+    return numStored;
+}
+
+bool SolutionPath::sharedWithPrevious(size_t l, int j) const{
+    return (l > 0) && (estimates[l].cols[j] == estimates[l - 1].cols[j]);
+}
+
+#endif
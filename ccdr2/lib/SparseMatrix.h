@@ -12,12 +12,15 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <cstdio>
 #include <math.h>
 
 #ifndef _COMPILE_FOR_RCPP_
     #include "defines.h"
 #endif
 
+#include "ColumnPool.h"
+
 extern double ZERO_THRESH; // defined in algorithm.h
 
 //------------------------------------------------------------------------------/
@@ -41,6 +44,10 @@ extern double ZERO_THRESH; // defined in algorithm.h
 //                  of the nonzero entries in column j; so that
 //                  vals[j][k] = val represents the value of edge a_ij.
 //
+//   The per-column vectors draw their storage from a pooled allocator (see ColumnPool.h),
+//     so that growing, copying and destroying matrices along the solution path recycles
+//     the same buffers instead of going back to the system allocator each time.
+//
 
 //
 // TRANSLATION: rows[j][k] -> location of (i,j)
@@ -88,6 +95,8 @@ public:
     int row(int j, int k) const;                            // get row index
     double value(int j, int k) const;                       // get row value
     int block(int j, int k) const;                          // get sibling row index
+    const int* rowptr(int j) const;                         // pointer to the (contiguous) row indices of column j
+    const double* valptr(int j) const;                      // pointer to the (contiguous) values of column j
     double sigma(int j) const;                              // get sigma value
     int find(int row, int col) const;                       // find the sparse row in rows[col] that holds the (row, col) element
     double findValue(int row, int col) const;               // find the edge weight that correspond to the (row, col) element
@@ -98,6 +107,7 @@ public:
     int recomputeNeighbourhoodSize(int j) const;            // manually recompute the number of parents at node j
     int activeSetSize() const;                              // return the number of blocks currently in the model (activeSetLength)
     int recomputeActiveSetSize(bool reset = false);         // manually recompute the number of nonzero values in the edge set and return a warning if warn = TRUE
+    void getValues(std::vector<double>& out) const;         // copy all stored values (column-major, sparse order) into out
 
     //
     // Mutator functions
@@ -108,6 +118,7 @@ public:
     double updateEdge(int j, int k, double val);                                    // update the value of an edge and return the difference 
     double update(int row, int col, double val);                                    // update the value of an edge and return the difference 
     void setSigma(int j, double s);                                                 // set the value of a residual parameter (sigma)
+    void setColumn(int j, const int* rows_in, const double* vals_in, int n);        // replace column j with n (row, val) pairs
     std::vector<double> addBlock(int row, int col, double valij, double valji);     // add a new block (i.e. an edge) to the model with values 'valij', 'valji'
     std::vector<double> updateBlock(int row, int col, double valij, double valji);  // update the value of an _existing_ block to the model with values 'valij', 'valji'
     void clearBlocks();       // zeroes out and frees memory associated with blocks vector (which is not needed for storage and access)
@@ -116,8 +127,13 @@ public:
     // Auxiliary member functions
     //
     int dim() const;            // dimension (i.e. # of nodes) in the model
+    SparseMatrix permute(const std::vector<int>& newLabel) const; // relabel the nodes: node j becomes node newLabel[j]
+    SparseMatrix restrict(const std::vector<int>& nodes) const;   // submatrix on the given nodes: node nodes[k] becomes node k
+    void embed(const SparseMatrix& local, const std::vector<int>& nodes); // inverse of restrict: write local back into this matrix
     void print() const;         // print out the _full_ beta matrix
     void print(int r) const;    // print out the upper rxr principal submatrix of betas (for suppressing large output)
+    void writeBinary(std::FILE* f) const;   // write the complete internal state to a binary file (see checkpoint.h)
+    bool readBinary(std::FILE* f, int expectedDim = -1);    // restore the internal state written by writeBinary; false on error
 
 #ifdef _COMPILE_FOR_RCPP_
     //
@@ -139,9 +155,9 @@ private:
     //
     // The main components of the data structure
     //
-    std::vector< std::vector<int> > rows;       // store the sparse row indices for each column
-    std::vector< std::vector<double> > vals;    // store the sparse row values for each column
-    std::vector< std::vector<int> > blocks;     // store the row index for block siblings
+    std::vector<IntColumn> rows;                // store the sparse row indices for each column
+    std::vector<DoubleColumn> vals;             // store the sparse row values for each column
+    std::vector<IntColumn> blocks;              // store the row index for block siblings
     std::vector<double> sigmas;                 // store the residual values (sigmas) from the CCDr algorithm
 
     //
@@ -183,10 +199,13 @@ void SparseMatrix::init(const std::vector< std::vector<int> >& rows_in,
     }
 
     // Populate the data structure using the supplied data
+    rows.reserve(pp);
+    vals.reserve(pp);
+    blocks.reserve(pp);
     for(int j = 0; j < pp; ++j){
-        rows.push_back(rows_in[j]);
-        vals.push_back(vals_in[j]);
-        blocks.push_back(blocks_in[j]);
+        rows.push_back(IntColumn(rows_in[j].begin(), rows_in[j].end()));
+        vals.push_back(DoubleColumn(vals_in[j].begin(), vals_in[j].end()));
+        blocks.push_back(IntColumn(blocks_in[j].begin(), blocks_in[j].end()));
         sigmas[j] = sigmas_in[j];
 
         // Update neighbourhood and active set sizes
@@ -211,13 +230,10 @@ SparseMatrix::SparseMatrix(int sizeOfMatrix){
     sigmas.resize(pp, 0);   // reserve necessary memory for sigmas vector and initialize all values to zero
 
     // Create empty vectors in each slot for rows / vals / blocks
-    for(int i = 0; i < pp; ++i){
-        rows.push_back(std::vector<int>(0));
-        vals.push_back(std::vector<double>(0));
-        blocks.push_back(std::vector<int>(0));
-
-        neighbourhoodSizes.push_back(0);
-    }
+    rows.resize(pp);
+    vals.resize(pp);
+    blocks.resize(pp);
+    neighbourhoodSizes.resize(pp, 0);
 }
 
 // Explicit constructor
@@ -267,6 +283,16 @@ int SparseMatrix::block(int j, int k) const{
     return blocks[j][k];
 }
 
+// Raw access to the jth column, used by the numeric kernels (see kernels.h)
+//  rowptr(j)[k] = row(j, k) and valptr(j)[k] = value(j, k) for k < rowsizes(j)
+const int* SparseMatrix::rowptr(int j) const{
+    return rows[j].data();
+}
+
+const double* SparseMatrix::valptr(int j) const{
+    return vals[j].data();
+}
+
 double SparseMatrix::sigma(int j) const{
     return sigmas[j];
 }
@@ -418,6 +444,16 @@ int SparseMatrix::recomputeActiveSetSize(bool reset){
     return re_activeSetLength;
 }
 
+// Copy every stored value into a single flat vector, column by column in sparse order
+//  This is the "coefficient vector" of the current active set; zero-valued entries are included so that
+//  the layout matches the sparse structure exactly (see moveToValues in algorithm.h)
+void SparseMatrix::getValues(std::vector<double>& out) const{
+    out.clear();
+    for(int j = 0; j < pp; ++j){
+        out.insert(out.end(), vals[j].begin(), vals[j].end());
+    }
+}
+
 // Update / set the value of vals[j][k]
 void SparseMatrix::setValueBySparseIndex(int j, int k, double v){
 
@@ -495,6 +531,19 @@ void SparseMatrix::setSigma(int j, double s){
     sigmas[j] = s;
 }
 
+// Replace the entire jth column with the n entries (rows_in[k], vals_in[k])
+//  Sibling indices (blocks) for this column are discarded, and the neighbourhood / active set sizes are
+//  recomputed from the new values
+void SparseMatrix::setColumn(int j, const int* rows_in, const double* vals_in, int n){
+    rows[j].assign(rows_in, rows_in + n);
+    vals[j].assign(vals_in, vals_in + n);
+    if(static_cast<int>(blocks.size()) == pp) blocks[j].clear();
+
+    activeSetLength -= neighbourhoodSizes[j];
+    neighbourhoodSizes[j] = recomputeNeighbourhoodSize(j);
+    activeSetLength += neighbourhoodSizes[j];
+}
+
 // Add a NEW block to the sparse-block structure
 //  Returns a vector containing the difference between the old values and the updated values; since
 //  we are adding a block the "old values" are always zero and this is reflected in the calculations
@@ -576,8 +625,10 @@ std::vector<double> SparseMatrix::updateBlock(int j, int k, double valij, double
 // Clear out / free the memory associated with the blocks vector
 //  This is useful when passing data back to R: Once the C++ code is finished running, the blocks vector is
 //  pretty much useless, and just takes up space. We free this memory before passing it back to R to keep
-//  the memory footprint down while the algorithm runs.
+//  the memory footprint down while the algorithm runs. Clearing blocks that are already cleared does nothing.
 void SparseMatrix::clearBlocks(){
+    if(blocks.empty()) return;
+
     #ifdef _DEBUG_ON_
         OUTPUT << "Clearing all data associated with blocks vector for this matrix.";
     #endif
@@ -594,6 +645,177 @@ int SparseMatrix::dim() const{
     return pp;
 }
 
+// Relabel the nodes of the model: node j becomes node newLabel[j] (see reorder.h)
+//  The order of the entries within each column is preserved, as are activeSetLength and the (optional)
+//  blocks vector, so the result behaves exactly like the original up to the relabeling.
+SparseMatrix SparseMatrix::permute(const std::vector<int>& newLabel) const{
+    SparseMatrix out(pp);
+
+    for(int j = 0; j < pp; ++j){
+        int nj = newLabel[j];
+
+        out.rows[nj].resize(rows[j].size());
+        for(size_t k = 0; k < rows[j].size(); ++k){
+            out.rows[nj][k] = newLabel[rows[j][k]];
+        }
+        out.vals[nj] = vals[j];
+        if(static_cast<int>(blocks.size()) == pp) out.blocks[nj] = blocks[j]; // sibling indices are unchanged since the order within columns is preserved
+
+        out.sigmas[nj] = sigmas[j];
+        out.neighbourhoodSizes[nj] = neighbourhoodSizes[j];
+    }
+
+    if(blocks.empty()) out.blocks.clear();
+    out.activeSetLength = activeSetLength;
+
+    return out;
+}
+
+// Submatrix on the given nodes (see components.h): node nodes[k] becomes node k, and the columns keep their order,
+//  values, sibling indices and sigmas. No edge may join a node in nodes to a node outside of it (every edge is stored
+//  in both of its columns, so the sibling indices would no longer match); activeSetLength is the sum of the
+//  neighbourhood sizes of the selected columns.
+SparseMatrix SparseMatrix::restrict(const std::vector<int>& nodes) const{
+    int n = static_cast<int>(nodes.size());
+    SparseMatrix out(n);
+
+    std::vector<int> local(pp, -1);
+    for(int k = 0; k < n; ++k) local[nodes[k]] = k;
+
+    out.activeSetLength = 0;
+    for(int k = 0; k < n; ++k){
+        int j = nodes[k];
+
+        out.rows[k].resize(rows[j].size());
+        for(size_t m = 0; m < rows[j].size(); ++m){
+            out.rows[k][m] = local[rows[j][m]];
+        }
+        out.vals[k] = vals[j];
+        if(static_cast<int>(blocks.size()) == pp) out.blocks[k] = blocks[j];
+
+        out.sigmas[k] = sigmas[j];
+        out.neighbourhoodSizes[k] = neighbourhoodSizes[j];
+        out.activeSetLength += neighbourhoodSizes[j];
+    }
+
+    if(blocks.empty()) out.blocks.clear();
+
+    return out;
+}
+
+// Write a submatrix built by restrict (on the same nodes) into this matrix, whose columns for nodes must still be
+//  empty. The other columns are left alone, so the estimates for the connected components of a problem can be
+//  merged one after another into an empty matrix; activeSetLength is the sum over the merged submatrices.
+void SparseMatrix::embed(const SparseMatrix& local, const std::vector<int>& nodes){
+    int n = static_cast<int>(nodes.size());
+
+    for(int k = 0; k < n; ++k){
+        int j = nodes[k];
+
+        rows[j].resize(local.rows[k].size());
+        for(size_t m = 0; m < local.rows[k].size(); ++m){
+            rows[j][m] = nodes[local.rows[k][m]];
+        }
+        vals[j] = local.vals[k];
+        if(static_cast<int>(blocks.size()) == pp){
+            if(static_cast<int>(local.blocks.size()) == n){
+                blocks[j] = local.blocks[k];
+            } else{
+                blocks[j].clear();
+            }
+        }
+
+        sigmas[j] = local.sigmas[k];
+        neighbourhoodSizes[j] = local.neighbourhoodSizes[k];
+    }
+
+    activeSetLength += local.activeSetLength;
+}
+
+//
+// Binary (de)serialization, used for checkpointing (see checkpoint.h)
+//  Every piece of internal state is written out exactly, including zero-valued entries, the order of the entries
+//  in each column and the incrementally-maintained counters, so that a restored matrix behaves identically to
+//  the original as a warm start. The layout is native-endian:
+//
+//    int pp, int activeSetLength, int hasBlocks, double sigmas[pp], int neighbourhoodSizes[pp],
+//    then for each column: int n, int rows[n], double vals[n], (if hasBlocks) int nb, int blocks[nb]
+//
+void SparseMatrix::writeBinary(std::FILE* f) const{
+    int hasBlocks = (static_cast<int>(blocks.size()) == pp) ? 1 : 0;
+    std::fwrite(&pp, sizeof(int), 1, f);
+    std::fwrite(&activeSetLength, sizeof(int), 1, f);
+    std::fwrite(&hasBlocks, sizeof(int), 1, f);
+    std::fwrite(sigmas.data(), sizeof(double), pp, f);
+    std::fwrite(neighbourhoodSizes.data(), sizeof(int), pp, f);
+
+    for(int j = 0; j < pp; ++j){
+        int n = static_cast<int>(rows[j].size());
+        std::fwrite(&n, sizeof(int), 1, f);
+        std::fwrite(rows[j].data(), sizeof(int), n, f);
+        std::fwrite(vals[j].data(), sizeof(double), n, f);
+
+        if(hasBlocks){
+            int nb = static_cast<int>(blocks[j].size());
+            std::fwrite(&nb, sizeof(int), 1, f);
+            std::fwrite(blocks[j].data(), sizeof(int), nb, f);
+        }
+    }
+}
+
+bool SparseMatrix::readBinary(std::FILE* f, int expectedDim){
+    int in_pp = 0, in_length = 0, hasBlocks = 0;
+    if(std::fread(&in_pp, sizeof(int), 1, f) != 1 || in_pp < 0) return false;
+    if(expectedDim >= 0 && in_pp != expectedDim) return false;
+    if(std::fread(&in_length, sizeof(int), 1, f) != 1 || in_length < 0) return false;
+    if(std::fread(&hasBlocks, sizeof(int), 1, f) != 1 || (hasBlocks != 0 && hasBlocks != 1)) return false;
+
+    pp = in_pp;
+    activeSetLength = in_length;
+    sigmas.resize(pp);
+    neighbourhoodSizes.resize(pp);
+    rows.assign(pp, IntColumn());
+    vals.assign(pp, DoubleColumn());
+    blocks.assign(hasBlocks ? pp : 0, IntColumn());
+
+    if(std::fread(sigmas.data(), sizeof(double), pp, f) != static_cast<size_t>(pp)) return false;
+    if(std::fread(neighbourhoodSizes.data(), sizeof(int), pp, f) != static_cast<size_t>(pp)) return false;
+
+    for(int j = 0; j < pp; ++j){
+        if(neighbourhoodSizes[j] < 0 || neighbourhoodSizes[j] > pp) return false;
+
+        // each row appears at most once in a column
+        int n = 0;
+        if(std::fread(&n, sizeof(int), 1, f) != 1 || n < 0 || n > pp) return false;
+        rows[j].resize(n);
+        vals[j].resize(n);
+        if(std::fread(rows[j].data(), sizeof(int), n, f) != static_cast<size_t>(n)) return false;
+        if(std::fread(vals[j].data(), sizeof(double), n, f) != static_cast<size_t>(n)) return false;
+
+        for(int k = 0; k < n; ++k){
+            if(rows[j][k] < 0 || rows[j][k] >= pp) return false;
+        }
+
+        if(hasBlocks){
+            int nb = 0;
+            if(std::fread(&nb, sizeof(int), 1, f) != 1 || nb < 0 || nb > n) return false;
+            blocks[j].resize(nb);
+            if(std::fread(blocks[j].data(), sizeof(int), nb, f) != static_cast<size_t>(nb)) return false;
+        }
+    }
+
+    // blocks[j][k] indexes into column rows[j][k] (see getSiblingValue), so it can only be checked once every
+    //  column has been read
+    for(int j = 0; j < static_cast<int>(blocks.size()); ++j){
+        for(size_t k = 0; k < blocks[j].size(); ++k){
+            int b = blocks[j][k];
+            if(b < 0 || b >= static_cast<int>(rows[rows[j][k]].size())) return false;
+        }
+    }
+
+    return true;
+}
+
 // print out the full betas matrix
 void SparseMatrix::print() const{
     for(int i = 0; i < pp; ++i){
@@ -678,11 +900,17 @@ void SparseMatrix::print(int r) const{
         }
 
         // Collect the internal vectors inside each R list to populate the data structure
+        rows.reserve(pp);
+        vals.reserve(pp);
+        blocks.reserve(pp);
         for(int j = 0; j < pp; ++j){
-            // Us as<> to convert R vectors to C++ STL vectors
-            rows.push_back(Rcpp::as< std::vector<int> >(rows_in[j]));
-            vals.push_back(Rcpp::as< std::vector<double> >(vals_in[j]));
-            blocks.push_back(Rcpp::as< std::vector<int> >(blocks_in[j]));
+            // Coerce the R vectors to the right type and copy them into the (pooled) column storage
+            Rcpp::IntegerVector rows_j = Rcpp::as<Rcpp::IntegerVector>(rows_in[j]);
+            Rcpp::NumericVector vals_j = Rcpp::as<Rcpp::NumericVector>(vals_in[j]);
+            Rcpp::IntegerVector blocks_j = Rcpp::as<Rcpp::IntegerVector>(blocks_in[j]);
+            rows.push_back(IntColumn(rows_j.begin(), rows_j.end()));
+            vals.push_back(DoubleColumn(vals_j.begin(), vals_j.end()));
+            blocks.push_back(IntColumn(blocks_j.begin(), blocks_j.end()));
             sigmas[j] = sigmas_in[j];
 
             // Update neighbourhood and active set sizes
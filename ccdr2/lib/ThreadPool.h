@@ -0,0 +1,394 @@
+//
+//  ThreadPool.h
+//  ccdr2
+//
+
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "ColumnPool.h"
+
+//------------------------------------------------------------------------------/
+//   THREAD POOL
+//------------------------------------------------------------------------------/
+
+//
+// A single work-stealing thread pool shared by every parallel part of the algorithm (screening, node ordering,
+//   connected components, parallel paths, ...), so that running several of them at once, or one inside another,
+//   never starts more threads than the global thread cap.
+//
+// Each worker has its own queue of tasks: it takes the most recent task from its own queue first (the one most
+//   likely to still be in cache), and once that is empty, steals the oldest task from the other queues. Tasks
+//   submitted from outside the pool go to a shared queue, unless an affinity hint asks for a particular worker:
+//   tasks with the same hint then tend to run on the same thread, until some other worker runs out of work and
+//   steals them. Tasks submitted from a worker go to its own queue.
+//
+// Tasks are grouped in TaskGroups. TaskGroup::wait does not just block: the waiting thread runs queued tasks until
+//   the whole group is done. This is what makes nested parallelism safe (a task can start a group of its own and
+//   wait for it), and it means the thread that starts a parallel stage always works on it too: with a cap of T
+//   threads, the pool itself only has T - 1 workers, and with a cap of 1 everything runs on the calling thread.
+//
+// The thread cap is global (see setThreadCap): 0 means one thread per core. Changing it replaces the pool, so it
+//   must not be called while any parallel work is running.
+//
+// Idle workers also return their cached column buffers (see ColumnPool.h) once asked to by releaseColumnCaches,
+//   so that the pool does not hold on to memory between runs.
+//
+// NOTES:
+//   -tasks must not block on anything other than TaskGroup::wait (otherwise they can hold up a worker forever)
+//   -an exception thrown by a task is passed on by TaskGroup::wait (only the first one, if several tasks throw)
+//
+
+class TaskGroup;
+
+class ThreadPool{
+
+public:
+    ~ThreadPool();
+
+    //
+    // Member functions
+    //
+    static ThreadPool& global();                    // the shared pool (created with the current cap on first use)
+    static void setThreadCap(unsigned int cap);     // maximum number of threads working at once (0 = one per core)
+    static unsigned int threadCap();                // the cap actually in use (never 0)
+    static void releaseColumnCaches();              // every thread (idle workers included) releases its ColumnPool
+
+    unsigned int size() const;                      // number of threads that can work at once, including the caller
+    bool runOne();                                  // run one queued task on the calling thread (false if none)
+
+private:
+    friend class TaskGroup;
+
+    struct Task{
+        std::function<void()> f;
+        TaskGroup* group;
+    };
+
+    struct Queue{
+        std::mutex mtx;
+        std::deque<Task> tasks;
+    };
+
+    ThreadPool(unsigned int nthreads);
+
+    void submit(TaskGroup& group, std::function<void()> f, int hint);
+    bool pop(int self, Task& t);                    // own queue first (newest task), then steal (oldest task)
+    void execute(Task& t);
+    void workerLoop(int self);
+    int selfIndex() const;                          // queue of the calling thread
+
+    std::vector< std::unique_ptr<Queue> > queues;   // one per worker, and a shared one (last) for other threads
+    std::vector<std::thread> workers;
+    std::atomic<int> queued;                        // total number of tasks waiting in the queues
+    std::atomic<unsigned int> nextSteal;            // where threads from outside the pool start looking for work
+    bool shutdown;
+
+    std::mutex sleepMtx;                            // idle threads sleep on wake (guarded by sleepMtx)
+    std::condition_variable wake;
+
+    static std::unique_ptr<ThreadPool>& instance();
+    static unsigned int& capSetting();
+    static std::mutex& globalMtx();
+    static ThreadPool*& currentPool();              // pool that the calling thread works for (NULL if none)
+    static int& currentIndex();                     // its worker index in that pool
+
+    ThreadPool(const ThreadPool&);                  // not copyable
+    ThreadPool& operator=(const ThreadPool&);
+};
+
+//
+// TaskGroup
+//
+//   A set of tasks that can be waited for together. The destructor waits for any task still running.
+//
+class TaskGroup{
+
+public:
+    TaskGroup(ThreadPool& in_pool = ThreadPool::global());
+    ~TaskGroup();
+
+    void run(std::function<void()> f, int hint = -1);  // queue f (hint >= 0: preferably on worker hint % workers)
+    void wait();                                        // run queued tasks until every task in the group is done
+
+private:
+    friend class ThreadPool;
+
+    ThreadPool& pool;
+    std::atomic<int> unfinished;
+    std::exception_ptr error;
+    std::mutex errorMtx;
+
+    TaskGroup(const TaskGroup&);                        // not copyable
+    TaskGroup& operator=(const TaskGroup&);
+};
+
+unsigned int resolveThreads(unsigned int threads, int n);
+template<class F> void forEachNode(int pp, unsigned int threads, F f);
+
+ThreadPool::ThreadPool(unsigned int nthreads){
+    queued = 0;
+    nextSteal = 0;
+    shutdown = false;
+
+    unsigned int nworkers = std::max(nthreads, 1u) - 1;
+    for(unsigned int q = 0; q <= nworkers; ++q) queues.push_back(std::unique_ptr<Queue>(new Queue));
+    for(unsigned int w = 0; w < nworkers; ++w) workers.push_back(std::thread(&ThreadPool::workerLoop, this, static_cast<int>(w)));
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(sleepMtx);
+        shutdown = true;
+    }
+    wake.notify_all();
+    for(size_t w = 0; w < workers.size(); ++w) workers[w].join();
+}
+
+std::unique_ptr<ThreadPool>& ThreadPool::instance(){
+    static std::unique_ptr<ThreadPool> pool;
+    return pool;
+}
+
+unsigned int& ThreadPool::capSetting(){
+    static unsigned int cap = 0;
+    return cap;
+}
+
+std::mutex& ThreadPool::globalMtx(){
+    static std::mutex mtx;
+    return mtx;
+}
+
+ThreadPool*& ThreadPool::currentPool(){
+    static thread_local ThreadPool* pool = NULL;
+    return pool;
+}
+
+int& ThreadPool::currentIndex(){
+    static thread_local int index = -1;
+    return index;
+}
+
+ThreadPool& ThreadPool::global(){
+    std::lock_guard<std::mutex> lock(globalMtx());
+    if(!instance()){
+        unsigned int cap = capSetting();
+        if(cap == 0) cap = std::max(1u, std::thread::hardware_concurrency());
+        instance().reset(new ThreadPool(cap));
+    }
+
+    return *instance();
+}
+
+void ThreadPool::setThreadCap(unsigned int cap){
+    std::lock_guard<std::mutex> lock(globalMtx());
+    if(cap == capSetting() && instance()) return;
+
+    capSetting() = cap;
+    instance().reset(); // joins the old workers (whose column caches go with them); the new pool is created on next use
+    ColumnPool::releaseAll();
+}
+
+void ThreadPool::releaseColumnCaches(){
+    ColumnPool::releaseAll();
+
+    // wake the idle workers, so that they release their caches now rather than at their next task
+    std::lock_guard<std::mutex> lock(globalMtx());
+    if(instance()){
+        ThreadPool& pool = *instance();
+        std::lock_guard<std::mutex> sleepLock(pool.sleepMtx);
+        pool.wake.notify_all();
+    }
+}
+
+unsigned int ThreadPool::threadCap(){
+    return global().size();
+}
+
+unsigned int ThreadPool::size() const{
+    return static_cast<unsigned int>(workers.size()) + 1;
+}
+
+int ThreadPool::selfIndex() const{
+    return (currentPool() == this) ? currentIndex() : static_cast<int>(workers.size());
+}
+
+void ThreadPool::submit(TaskGroup& group, std::function<void()> f, int hint){
+    int q = selfIndex();
+    if(hint >= 0 && !workers.empty()) q = hint % static_cast<int>(workers.size());
+
+    group.unfinished++;
+    {
+        Queue& queue = *queues[q];
+        std::lock_guard<std::mutex> lock(queue.mtx);
+        Task t;
+        t.f = std::move(f);
+        t.group = &group;
+        queue.tasks.push_back(std::move(t));
+    }
+    queued++;
+
+    std::lock_guard<std::mutex> lock(sleepMtx);
+    wake.notify_one();
+}
+
+bool ThreadPool::pop(int self, Task& t){
+    if(queued == 0) return false;
+
+    // own queue: newest task first
+    {
+        Queue& queue = *queues[self];
+        std::lock_guard<std::mutex> lock(queue.mtx);
+        if(!queue.tasks.empty()){
+            t = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+
+    // steal: oldest task first, starting from the next queue over (threads from outside the pool take turns)
+    int nq = static_cast<int>(queues.size());
+    int start = (self == nq - 1) ? static_cast<int>(nextSteal++ % nq) : self + 1;
+    for(int k = 0; k < nq; ++k){
+        int q = (start + k) % nq;
+        if(q == self) continue;
+
+        Queue& queue = *queues[q];
+        std::lock_guard<std::mutex> lock(queue.mtx);
+        if(!queue.tasks.empty()){
+            t = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::execute(Task& t){
+    TaskGroup& group = *t.group;
+    try{
+        t.f();
+    } catch(...){
+        std::lock_guard<std::mutex> lock(group.errorMtx);
+        if(!group.error) group.error = std::current_exception();
+    }
+    t.f = std::function<void()>(); // release whatever the task holds before the group is marked done
+
+    if(--group.unfinished == 0){
+        std::lock_guard<std::mutex> lock(sleepMtx);
+        wake.notify_all();
+    }
+}
+
+bool ThreadPool::runOne(){
+    Task t;
+    if(!pop(selfIndex(), t)) return false;
+
+    execute(t);
+    return true;
+}
+
+void ThreadPool::workerLoop(int self){
+    currentPool() = this;
+    currentIndex() = self;
+
+    for(;;){
+        Task t;
+        if(pop(self, t)){
+            execute(t);
+            continue;
+        }
+
+        ColumnPool& columns = ColumnPool::local();
+        columns.releaseIfStale();
+
+        std::unique_lock<std::mutex> lock(sleepMtx);
+        wake.wait(lock, [this, &columns](){ return shutdown || queued > 0 || columns.stale(); });
+        if(shutdown && queued == 0) return;
+    }
+}
+
+TaskGroup::TaskGroup(ThreadPool& in_pool)
+: pool(in_pool), unfinished(0){
+}
+
+TaskGroup::~TaskGroup(){
+    try{
+        wait();
+    } catch(...){
+        // only reachable if the owner never called wait(); nothing sensible to do with the error here
+    }
+}
+
+void TaskGroup::run(std::function<void()> f, int hint){
+    pool.submit(*this, std::move(f), hint);
+}
+
+void TaskGroup::wait(){
+    while(unfinished > 0){
+        if(pool.runOne()) continue;
+
+        // nothing to run: sleep until a task is queued or this group is done
+        std::unique_lock<std::mutex> lock(pool.sleepMtx);
+        pool.wake.wait(lock, [this](){ return unfinished == 0 || pool.queued > 0; });
+    }
+
+    std::lock_guard<std::mutex> lock(errorMtx);
+    if(error){
+        std::exception_ptr e = error;
+        error = std::exception_ptr();
+        std::rethrow_exception(e);
+    }
+}
+
+//
+// resolveThreads
+//
+//   The number of threads to actually use for n independent pieces of work: 0 means as many as the global thread
+//     cap allows, and there is never more than the cap, nor more than one thread per piece
+//
+unsigned int resolveThreads(unsigned int threads, int n){
+    unsigned int cap = ThreadPool::threadCap();
+    if(threads == 0 || threads > cap) threads = cap;
+
+    return std::min(threads, static_cast<unsigned int>(std::max(n, 1)));
+}
+
+//
+// forEachNode
+//
+//   Calls f(j) once for every node j < pp, on (at most) the given number of threads of the shared pool (0 = as many
+//     as allowed). The nodes are handed out one at a time, so that a few expensive nodes do not hold up the rest.
+//     f must only write to state that belongs to node j; it may itself run work on the pool.
+//
+template<class F>
+void forEachNode(int pp, unsigned int threads, F f){
+    threads = resolveThreads(threads, pp);
+
+    std::atomic<int> next(0);
+    auto worker = [&](){
+        for(int j = next++; j < pp; j = next++) f(j);
+    };
+
+    TaskGroup group;
+    for(unsigned int t = 1; t < threads; ++t) group.run(worker);
+    worker();
+    group.wait();
+}
+
+#endif
@@ -23,6 +23,11 @@
 #include <iostream>
 #include <math.h>
 #include <time.h>  // for testing and profiling only
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #ifndef _COMPILE_FOR_RCPP_
     #include "defines.h"
@@ -30,10 +35,21 @@
 
 #include "Matrix.h"
 #include "SparseMatrix.h"
+#include "SolutionPath.h"
+#include "PathSink.h"
+#include "checkpoint.h"
+#include "EdgeArrays.h"
 #include "BlockList.h"
 #include "PenaltyFunction.h"
 #include "CCDrAlgorithm.h"
+#include "AndersonAccelerator.h"
 #include "correlation.h"
+#include "kernels.h"
+#include "reorder.h"
+#include "ThreadPool.h"
+#include "screening.h"
+#include "components.h"
+#include "ensemble.h"
 #include "debug.h"
 
 //------------------------------------------------------------------------------/
@@ -51,6 +67,26 @@ double ZERO_THRESH = 1e-12;
 #endif
 //------------------------------------------------------------------------------/
 
+//------------------------------------------------------------------------------/
+//   PARALLEL PATH TYPES (see parallelGridCCDr)
+//
+
+struct ParallelPathStats{
+    unsigned int solves;            // total number of calls to singleCCDr
+    unsigned int segments;          // number of independent parts the grid was split into
+};
+//------------------------------------------------------------------------------/
+
+//------------------------------------------------------------------------------/
+//   EDGE TARGET TYPES (see targetEdgesCCDr)
+//
+struct EdgeTargetResult{
+    SolutionPath fits;                  // every fit computed during the search, in order of decreasing lambda
+    std::vector<LambdaStats> stats;     // stats for each fit (same order)
+    size_t best;                        // the fit whose number of edges is closest to the target
+};
+//------------------------------------------------------------------------------/
+
 // old debug code used to be here
 
 //------------------------------------------------------------------------------/
@@ -59,24 +95,226 @@ double ZERO_THRESH = 1e-12;
 
 // prototype for gridCCDr
 std::vector<SparseMatrix> gridCCDr(const std::vector<double>& corvec,    // array containing the correlations between predictors
-                                        std::vector<double> sigmas,
-                                        SparseMatrix betas,            // initial guess of beta matrix
+                                        SparseMatrix betas,            // initial guess of beta matrix (may be moved in)
+                                        const std::vector<double>& sigmas,
                                         const unsigned int nn,              // # of rows in data matrix
                                         const std::vector<double>& lambdas, // vector containing the grid of regularization parameters to be tested
                                         const std::vector<double>& params,  // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
                                         const int verbose,                  // binary variable to specify whether or not to print progress reports
-                                        const BlockList blocks
+                                        const BlockList& blocks
                                         );
 
+// prototype for gridCCDr (streaming version)
+void gridCCDr(const std::vector<double>& corvec,                    // array containing the correlations between predictors
+              SparseMatrix betas,                                   // initial guess of beta matrix (may be moved in)
+              const std::vector<double>& sigmas,
+              const unsigned int nn,                                // # of rows in data matrix
+              const std::vector<double>& lambdas,                   // vector containing the grid of regularization parameters to be tested
+              const std::vector<double>& params,                    // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
+              const int verbose,                                    // binary variable to specify whether or not to print progress reports
+              const BlockList& blocks,
+              PathSink& sink                                        // receives each estimate as soon as it is computed
+              );
+
+// prototype for gridCCDrFrom
+void gridCCDrFrom(const std::vector<double>& corvec,                // array containing the correlations between predictors
+                  SparseMatrix betas,                               // estimate to start from at lambdas[firstLambda] (may be moved in)
+                  const std::vector<double>& sigmas,
+                  const unsigned int nn,                            // # of rows in data matrix
+                  const std::vector<double>& lambdas,               // vector containing the grid of regularization parameters to be tested
+                  const unsigned int firstLambda,                   // index of the first value of lambda to compute
+                  const std::vector<double>& params,                // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
+                  const int verbose,                                // binary variable to specify whether or not to print progress reports
+                  const BlockList& blocks,
+                  PathSink& sink                                    // receives each estimate as soon as it is computed
+                  );
+
+// prototype for gridCCDr (streaming version, full correlation matrix)
+void gridCCDr(const Matrix<double>& cors,                           // full correlation matrix (may be a view, see Matrix.h)
+              SparseMatrix betas,                                   // initial guess of beta matrix (may be moved in)
+              const std::vector<double>& sigmas,
+              const unsigned int nn,                                // # of rows in data matrix
+              const std::vector<double>& lambdas,                   // vector containing the grid of regularization parameters to be tested
+              const std::vector<double>& params,                    // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
+              const int verbose,                                    // binary variable to specify whether or not to print progress reports
+              const BlockList& blocks,
+              PathSink& sink                                        // receives each estimate as soon as it is computed
+              );
+
+// prototype for gridCCDrFrom (full correlation matrix)
+void gridCCDrFrom(const Matrix<double>& cors,                       // full correlation matrix (may be a view, see Matrix.h)
+                  SparseMatrix betas,                               // estimate to start from at lambdas[firstLambda] (may be moved in)
+                  const std::vector<double>& sigmas,
+                  const unsigned int nn,                            // # of rows in data matrix
+                  const std::vector<double>& lambdas,               // vector containing the grid of regularization parameters to be tested
+                  const unsigned int firstLambda,                   // index of the first value of lambda to compute
+                  const std::vector<double>& params,                // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
+                  const int verbose,                                // binary variable to specify whether or not to print progress reports
+                  const BlockList& blocks,
+                  PathSink& sink                                    // receives each estimate as soon as it is computed
+                  );
+
+// prototype for checkpointedGridCCDr
+void checkpointedGridCCDr(const std::vector<double>& corvec,        // array containing the correlations between predictors
+                          SparseMatrix betas,                       // initial guess of beta matrix (may be moved in)
+                          const std::vector<double>& sigmas,
+                          const unsigned int nn,                    // # of rows in data matrix
+                          const std::vector<double>& lambdas,       // vector containing the grid of regularization parameters to be tested
+                          const std::vector<double>& params,        // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
+                          const int verbose,                        // binary variable to specify whether or not to print progress reports
+                          const BlockList& blocks,
+                          PathSink& sink,                           // receives each estimate as soon as it is computed
+                          const std::string& checkpoint_file,       // where to write checkpoints
+                          const unsigned int every                  // write a checkpoint after every 'every' values of lambda
+                          );
+
+// prototype for resumeGridCCDr
+bool resumeGridCCDr(const std::string& checkpoint_file,             // checkpoint written by checkpointedGridCCDr
+                    const std::vector<double>& corvec,              // array containing the correlations between predictors (same as the original run)
+                    const int verbose,                              // binary variable to specify whether or not to print progress reports
+                    const BlockList& blocks,                        // same as the original run
+                    PathSink& sink,                                 // receives every estimate, including those already completed
+                    const unsigned int every                        // write a checkpoint after every 'every' values of lambda
+                    );
+
+// prototype for gridCCDrPath
+SolutionPath gridCCDrPath(const std::vector<double>& corvec,        // array containing the correlations between predictors
+                          SparseMatrix betas,                       // initial guess of beta matrix (may be moved in)
+                          const std::vector<double>& sigmas,
+                          const unsigned int nn,                    // # of rows in data matrix
+                          const std::vector<double>& lambdas,       // vector containing the grid of regularization parameters to be tested
+                          const std::vector<double>& params,        // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
+                          const int verbose,                        // binary variable to specify whether or not to print progress reports
+                          const BlockList& blocks
+                          );
+
+// prototype for parallelGridCCDr
+ParallelPathStats parallelGridCCDr(const std::vector<double>& corvec,   // array containing the correlations between predictors
+                                   const SparseMatrix& betas,           // initial guess of beta matrix
+                                   const std::vector<double>& sigmas,
+                                   const unsigned int nn,               // # of rows in data matrix
+                                   const std::vector<double>& lambdas,  // vector containing the grid of regularization parameters to be tested
+                                   const std::vector<double>& params,   // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
+                                   const int verbose,                   // binary variable to specify whether or not to print progress reports
+                                   const BlockList& blocks,
+                                   PathSink& sink,                      // receives each estimate, in order
+                                   const unsigned int segments,         // number of independent parts of the grid
+                                   const unsigned int threads           // number of worker threads (0 = up to the thread cap)
+                                   );
+
+// prototype for parallelGridCCDr (full correlation matrix)
+ParallelPathStats parallelGridCCDr(const Matrix<double>& cors,          // full correlation matrix (may be a view, see Matrix.h)
+                                   const SparseMatrix& betas,           // initial guess of beta matrix
+                                   const std::vector<double>& sigmas,
+                                   const unsigned int nn,               // # of rows in data matrix
+                                   const std::vector<double>& lambdas,  // vector containing the grid of regularization parameters to be tested
+                                   const std::vector<double>& params,   // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
+                                   const int verbose,                   // binary variable to specify whether or not to print progress reports
+                                   const BlockList& blocks,
+                                   PathSink& sink,                      // receives each estimate, in order
+                                   const unsigned int segments,         // number of independent parts of the grid
+                                   const unsigned int threads           // number of worker threads (0 = up to the thread cap)
+                                   );
+
+// prototype for componentGridCCDr
+unsigned int componentGridCCDr(const Matrix<double>& cors,          // full correlation matrix (may be a view, see Matrix.h)
+                               const SparseMatrix& betas,           // initial guess of beta matrix
+                               const std::vector<double>& sigmas,
+                               const unsigned int nn,               // # of rows in data matrix
+                               const std::vector<double>& lambdas,  // vector containing the grid of regularization parameters to be tested
+                               const std::vector<double>& params,   // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
+                               const int verbose,                   // binary variable to specify whether or not to print progress reports
+                               const BlockList& blocks,
+                               PathSink& sink,                      // receives each estimate, in order
+                               const unsigned int threads           // number of worker threads (0 = up to the thread cap)
+                               );
+
+// prototype for ensembleGridCCDr
+EdgeFrequencies ensembleGridCCDr(const Matrix<double>& cors,        // full correlation matrix (may be a view, see Matrix.h)
+                                 const SparseMatrix& betas,         // initial guess of beta matrix
+                                 const std::vector<double>& sigmas,
+                                 const unsigned int nn,             // # of rows in data matrix
+                                 const std::vector<double>& lambdas, // vector containing the grid of regularization parameters to be tested
+                                 const std::vector<double>& params, // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
+                                 const int verbose,                 // binary variable to specify whether or not to print progress reports
+                                 const BlockList& blocks,
+                                 const unsigned int copies,         // number of randomized copies of the path
+                                 const unsigned int threads,        // number of worker threads (0 = up to the thread cap)
+                                 std::vector<EdgeArrays>* paths     // if not NULL, receives the path of each copy
+                                 );
+
+// prototype for adaptiveGridCCDr
+unsigned int adaptiveGridCCDr(const std::vector<double>& corvec,    // array containing the correlations between predictors
+                              SparseMatrix betas,                   // initial guess of beta matrix (may be moved in)
+                              const std::vector<double>& sigmas,
+                              const unsigned int nn,                // # of rows in data matrix
+                              const std::vector<double>& lambdas,   // initial (coarse) grid of regularization parameters, decreasing
+                              const unsigned int maxFits,           // total number of calls to singleCCDr allowed, including the coarse grid
+                              const int maxEdgeJump,                // refine where the edge count changes by more than this (<= 0 => ignore)
+                              const double maxObjectiveJump,        // refine where the objective changes by more than this, relative (<= 0 => ignore)
+                              const std::vector<double>& params,    // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
+                              const int verbose,                    // binary variable to specify whether or not to print progress reports
+                              const BlockList& blocks,
+                              PathSink& sink                        // receives the refined path, in order of decreasing lambda
+                              );
+
+// prototype for targetEdgesCCDr
+EdgeTargetResult targetEdgesCCDr(const std::vector<double>& corvec,    // array containing the correlations between predictors
+                                 SparseMatrix betas,                   // initial guess of beta matrix (may be moved in)
+                                 const std::vector<double>& sigmas,
+                                 const unsigned int nn,                // # of rows in data matrix
+                                 const int targetEdges,                // desired number of edges
+                                 const double maxlam,                  // largest value of lambda to try (usually sqrt(nn))
+                                 const double minlam,                  // smallest value of lambda to try
+                                 const unsigned int maxFits,           // maximum number of calls to singleCCDr
+                                 const std::vector<double>& params,    // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
+                                 const int verbose,                    // binary variable to specify whether or not to print progress reports
+                                 const BlockList& blocks
+                                 );
+
+// prototype for reorderedGridCCDr
+std::vector<SparseMatrix> reorderedGridCCDr(const std::vector<double>& corvec,    // array containing the correlations between predictors
+                                            const SparseMatrix& betas,            // initial guess of beta matrix
+                                            const std::vector<double>& sigmas,
+                                            const unsigned int nn,                // # of rows in data matrix
+                                            const std::vector<double>& lambdas,   // vector containing the grid of regularization parameters to be tested
+                                            const std::vector<double>& params,    // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
+                                            const int verbose,                    // binary variable to specify whether or not to print progress reports
+                                            const BlockList& blocks
+                                            );
+void reorderedGridCCDr(const Matrix<double>& cors,                       // full correlation matrix (may be a view, see Matrix.h)
+                       const SparseMatrix& betas,                        // initial guess of beta matrix
+                       const std::vector<double>& sigmas,
+                       const unsigned int nn,                            // # of rows in data matrix
+                       const std::vector<double>& lambdas,               // vector containing the grid of regularization parameters to be tested
+                       const std::vector<double>& params,                // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
+                       const int verbose,                                // binary variable to specify whether or not to print progress reports
+                       const BlockList& blocks,
+                       PathSink& sink                                    // receives each estimate (in the original labels), in order
+                       );
+
 // prototype for singleCCDr
 SparseMatrix singleCCDr(const std::vector<double>& corvec,   // array containing the correlations between predictors
-                             SparseMatrix betas,           // initial guess of beta matrix
-                             std::vector<double> sigmas,
+                             SparseMatrix betas,           // initial guess of beta matrix (may be moved in)
+                             const std::vector<double>& sigmas,
                              const unsigned int nn,             // # of rows in data matrix
                              const double lambda,               // value of regularization parameter
                              const std::vector<double>& params, // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
                              const int verbose,                 // binary variable to specify whether or not to print progress reports
-                             const BlockList blocks
+                             const BlockList& blocks
+);
+
+// prototype for singleCCDr (in-place version)
+SolveStatus singleCCDr(const Matrix<double>& cors,                    // full correlation matrix (see cor_vector_to_Matrix)
+                SparseMatrix& betas,                           // initial guess of beta matrix; overwritten with the estimate
+                const std::vector<double>& sigmas,
+                const unsigned int nn,                         // # of rows in data matrix
+                const double lambda,                           // value of regularization parameter
+                const std::vector<double>& params,             // vector containing user-defined parameters: {gamma, eps, maxIters, alpha}
+                const int verbose,                             // binary variable to specify whether or not to print progress reports
+                const BlockList& blocks,
+                const WorkBudget& budget,                      // limits on the work done for this value of lambda
+                const uint64_t stream = 0                      // random number stream for randomize = true (see CounterRNG.h)
 );
 
 // prototype for computeEdgeLoss
@@ -112,6 +350,29 @@ void concaveCD(const double lambda,                             // value of regu
                const int verbose                                // binary variable to specify whether or not to print progress reports
                );
 
+// prototype for computeSigmas
+void computeSigmas(const unsigned int nn,                       // # of rows in data matrix
+                   SparseMatrix& betas,                         // current value of beta matrix
+                   CCDrAlgorithm& alg,                          // CCDrAlgorithm object for this run (holds the sigma cache)
+                   const Matrix<double>& cors                   // array containing the correlations between predictors
+);
+
+// prototype for moveToValues
+void moveToValues(SparseMatrix& betas,                          // current value of beta matrix
+                  CCDrAlgorithm& alg,                           // CCDrAlgorithm object for this run (error and sigma cache)
+                  const Matrix<double>& cors,                   // array containing the correlations between predictors
+                  const std::vector<double>& x                  // new values, in the layout of SparseMatrix::getValues
+);
+
+// prototype for computeObjective
+double computeObjective(const double lambda,                    // value of regularization parameter
+                        const unsigned int nn,                  // # of rows in data matrix
+                        const SparseMatrix& betas,              // current value of beta matrix
+                        const PenaltyFunction& pen,             // penalty function
+                        const Matrix<double>& cors,             // array containing the correlations between predictors
+                        const bool profileSigmas                // if true, use the optimal sigmas given betas instead of the stored ones
+);
+
 //prototype for singleUpdate
 double singleUpdate(const unsigned int a,                       // initial node (i.e. update beta_ab)
                     const unsigned int b,                       // terminal node (i.e. update beta_ab)
@@ -156,28 +417,187 @@ bool checkCycleSparse(const int node,                    // number of nodes in g
 //     -betas and lambdas can be anything to start with
 //     -the C++ code enforces no defaults; these are all implemented in R
 //     -it is very important that the params values are passed in the CORRECT ORDER: {gamma, eps, maxIters, alpha}
+//     -this is a thin wrapper around gridCCDrPath, which stores the path compactly; use that function directly
+//       for large problems where the full copies returned here do not fit in memory
 //
 std::vector<SparseMatrix> gridCCDr(const std::vector<double>& corvec,
                                         SparseMatrix betas,
-                                        std::vector<double> sigmas,
+                                        const std::vector<double>& sigmas,
                                         const unsigned int nn,
                                         const std::vector<double>& lambdas,
                                         const std::vector<double>& params,
                                         const int verbose,
-                                        const BlockList blocks
+                                        const BlockList& blocks
                                         ){
+    return gridCCDrPath(corvec, std::move(betas), sigmas, nn, lambdas, params, verbose, blocks).materializeAll();
+}
+
+//
+// gridCCDrPath
+//
+//   Same as gridCCDr, but returns the estimates as a SolutionPath, which shares the columns that do not change
+//     from one value of lambda to the next instead of storing a full copy of every estimate (see SolutionPath.h).
+//     Any estimate can be accessed in O(1) time and converted to a SparseMatrix with materialize().
+//
+//   Output: A SolutionPath with one estimate for each value of lambda in lambdas (up to the point where the
+//     algorithm terminates)
+//
+SolutionPath gridCCDrPath(const std::vector<double>& corvec,
+                          SparseMatrix betas,
+                          const std::vector<double>& sigmas,
+                          const unsigned int nn,
+                          const std::vector<double>& lambdas,
+                          const std::vector<double>& params,
+                          const int verbose,
+                          const BlockList& blocks
+                          ){
+    MemoryPathSink sink;
+    gridCCDr(corvec, std::move(betas), sigmas, nn, lambdas, params, verbose, blocks, sink);
+
+    return std::move(sink.path());
+}
+
+//
+// gridCCDr (streaming version)
+//
+//   Runs the same path as gridCCDr, but instead of returning the estimates, passes each one to sink as soon as
+//     it has been computed, along with the value of lambda and some statistics (timing, number of passes, number
+//     of edges). What is kept is up to the sink: see PathSink.h for the stock sinks (in memory, last K only,
+//     write to file, callback).
+//
+//   Output: void (everything goes to sink)
+//
+//   NOTES:
+//     -the full correlation matrix is built once for the whole path, and betas is updated in place from one
+//       value of lambda to the next
+//     -sink.finish() is called once the path is done (including when the algorithm terminates early)
+//     -params may contain work budgets (see WorkBudget in CCDrAlgorithm.h): params[6..8] limit the work done for
+//       each value of lambda, and params[9..11] the work done for the whole path. An estimate cut short by a
+//       budget is still passed to sink, with the reason in LambdaStats::status; once the path budget is used
+//       up, the remaining values of lambda are skipped
+//
+void gridCCDr(const std::vector<double>& corvec,
+              SparseMatrix betas,
+              const std::vector<double>& sigmas,
+              const unsigned int nn,
+              const std::vector<double>& lambdas,
+              const std::vector<double>& params,
+              const int verbose,
+              const BlockList& blocks,
+              PathSink& sink
+              ){
+    gridCCDrFrom(corvec, std::move(betas), sigmas, nn, lambdas, 0, params, verbose, blocks, sink);
+}
+
+//
+// gridCCDr (streaming version, full correlation matrix)
+//
+//   Same as above, but takes the full correlation matrix instead of the packed upper triangle. Since cors may be
+//     a view (see Matrix.h), this lets callers that already have the full matrix (e.g. crossprod in R) run the
+//     path without any copy of the correlations at all.
+//
+void gridCCDr(const Matrix<double>& cors,
+              SparseMatrix betas,
+              const std::vector<double>& sigmas,
+              const unsigned int nn,
+              const std::vector<double>& lambdas,
+              const std::vector<double>& params,
+              const int verbose,
+              const BlockList& blocks,
+              PathSink& sink
+              ){
+    gridCCDrFrom(cors, std::move(betas), sigmas, nn, lambdas, 0, params, verbose, blocks, sink);
+}
+
+//
+// tightenBudget
+//
+//   Cap budget by what is left of pathBudget, given the work already done along the path. Returns false if
+//     pathBudget is already used up.
+//
+bool tightenBudget(WorkBudget& budget,
+                   const WorkBudget& pathBudget,
+                   double seconds,
+                   double passes,
+                   double evals
+                   ){
+    double left[3] = {pathBudget.seconds - seconds, pathBudget.passes - passes, pathBudget.evals - evals};
+    double limit[3] = {pathBudget.seconds, pathBudget.passes, pathBudget.evals};
+    double* b[3] = {&budget.seconds, &budget.passes, &budget.evals};
+
+    for(int k = 0; k < 3; ++k){
+        if(limit[k] <= 0) continue;     // no limit on the path
+        if(left[k] <= 0) return false;  // path budget used up
+
+        if(*b[k] <= 0 || left[k] < *b[k]) *b[k] = left[k];
+    }
+
+    return true;
+}
+
+//
+// gridCCDrFrom
+//
+//   Same as the streaming gridCCDr, but starts at lambdas[firstLambda] with betas as the warm start. This is what
+//     resumeGridCCDr uses to continue a path from a checkpoint: since betas is exactly the estimate for the
+//     previous value of lambda, the remaining estimates are the same as in an uninterrupted run.
+//
+//   NOTES:
+//     -the packed version only expands corvec into the full correlation matrix and calls the full-matrix version
+//     -the active set counter of betas is updated incrementally by the solver and can drift above the number of
+//       edges, so it is recomputed after every value of lambda (whether or not verbose is set, so that the next
+//       warm start does not depend on it). The path stops after the first estimate with MORE than alpha * pp
+//       edges, as the loop over ccdr_singleR in R did
+//
+void gridCCDrFrom(const std::vector<double>& corvec,
+                  SparseMatrix betas,
+                  const std::vector<double>& sigmas,
+                  const unsigned int nn,
+                  const std::vector<double>& lambdas,
+                  const unsigned int firstLambda,
+                  const std::vector<double>& params,
+                  const int verbose,
+                  const BlockList& blocks,
+                  PathSink& sink
+                  ){
+    Matrix<double> cors = cor_vector_to_Matrix(corvec, betas.dim());
+    gridCCDrFrom(cors, std::move(betas), sigmas, nn, lambdas, firstLambda, params, verbose, blocks, sink);
+}
+
+void gridCCDrFrom(const Matrix<double>& cors,
+                  SparseMatrix betas,
+                  const std::vector<double>& sigmas,
+                  const unsigned int nn,
+                  const std::vector<double>& lambdas,
+                  const unsigned int firstLambda,
+                  const std::vector<double>& params,
+                  const int verbose,
+                  const BlockList& blocks,
+                  PathSink& sink
+                  ){
     #ifdef _DEBUG_ON_
-        FILE_LOG(logDEBUG2) << "Function call: gridCCDr";
+        FILE_LOG(logDEBUG2) << "Function call: gridCCDrFrom";
     #endif
 
     int nlam = static_cast<int>(lambdas.size());    // how many values of lambda are in the supplied grid?
     double alpha = params[3];                       // value of alpha; needed to know when to terminate algorithm
-    std::vector<SparseMatrix> grid_betas;      // the vector of SBMs that will eventually be returned
+
+    // work budgets: per lambda, and for the whole path (i.e. for this call)
+    WorkBudget lambdaBudget = budgetFromParams(params, 6);
+    WorkBudget pathBudget = budgetFromParams(params, 9);
+    std::chrono::steady_clock::time_point pathStart = std::chrono::steady_clock::now();
+    double pathPasses = 0, pathEvals = 0;           // work done so far along the path
+
+    //--- VERBOSE ONLY ---//
+    if(verbose){
+        OUTPUT << "Using " << kernelVariant() << " numeric kernels";
+    }
+    //--------------------//
 
     //
     // This function is simple: Simply call singleCCDr repeatedly for each value of lambda supplied
     //
-    for(int l = 0; l < nlam; ++l){
+    for(int l = static_cast<int>(firstLambda); l < nlam; ++l){
         double lambda = lambdas[l]; // current value of lambda in the grid
 
         //--- VERBOSE ONLY ---//
@@ -190,10 +610,42 @@ std::vector<SparseMatrix> gridCCDr(const std::vector<double>& corvec,
         }
         //--------------------//
 
+        //
+        // The budget for this value of lambda is the per-lambda budget, capped by whatever is left of the path
+        //   budget. Once the path budget is used up, no more values of lambda are attempted.
+        //
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        WorkBudget budget = lambdaBudget;
+        if(!pathBudget.unlimited()){
+            double pathSeconds = std::chrono::duration<double>(start - pathStart).count();
+            if(!tightenBudget(budget, pathBudget, pathSeconds, pathPasses, pathEvals)){
+                //--- VERBOSE ONLY ---//
+                if(verbose){
+                    OUTPUT << " | path budget used up, stopping" << std::endl;
+                }
+                //--------------------//
+
+                break;
+            }
+        }
+
         // To save memory, simply overwrite the same object (betas)
-        // After each call to singleCCDr, we push_back the estimated object to grid_betas so there is no loss of data
-        betas = singleCCDr(corvec, betas, sigmas, nn, lambda, params, verbose, blocks);
-        grid_betas.push_back(betas);
+        // After each call to singleCCDr, we hand the estimate to the sink, which decides what to keep
+        SolveStatus result = singleCCDr(cors, betas, sigmas, nn, lambda, params, verbose, blocks, budget, l);
+        pathPasses += result.iters;
+        pathEvals += result.evals;
+
+        LambdaStats stats;
+        stats.index = l;
+        stats.lambda = lambda;
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats.iters = result.iters;
+        stats.nedges = betas.recomputeActiveSetSize(true); // the running count can drift, so reset it (see NOTES)
+        stats.sweeps = result.sweeps;
+        stats.evals = result.evals;
+        stats.error = result.error;
+        stats.status = result.status;
+        sink.consume(betas, stats);
 
         //--- VERBOSE ONLY ---//
         if(verbose){
@@ -208,19 +660,994 @@ std::vector<SparseMatrix> gridCCDr(const std::vector<double>& corvec,
         }
         //--------------------//
 
-        // Once an estimate has been computed, the blocks vector is superfluous and so we get rid of it to save memory
-        // This is negligible for small models, but in order to push the limits of the algorithm (i.e. pp in thousands+)
-        //   we need to save memory wherever possible
-        grid_betas[l].clearBlocks();
+        if(stats.nedges > alpha * betas.dim()){
+            break;
+        }
+    }
+
+    sink.finish();
+}
+
+//
+// checkpointedGridCCDr
+//
+//   Same as the streaming gridCCDr, but also writes a checkpoint to checkpoint_file after every 'every' values
+//     of lambda, and once the path is done (see checkpoint.h). If the job is killed, resumeGridCCDr continues the
+//     path from the last checkpoint.
+//
+void checkpointedGridCCDr(const std::vector<double>& corvec,
+                          SparseMatrix betas,
+                          const std::vector<double>& sigmas,
+                          const unsigned int nn,
+                          const std::vector<double>& lambdas,
+                          const std::vector<double>& params,
+                          const int verbose,
+                          const BlockList& blocks,
+                          PathSink& sink,
+                          const std::string& checkpoint_file,
+                          const unsigned int every
+                          ){
+    CheckpointInfo info;
+    info.nn = nn;
+    info.numBlocks = blocks.size();
+    info.corsHash = hashCors(corvec);
+    info.blocksHash = hashBlocks(blocks);
+    info.kernels = kernelVariant();
+    info.lambdas = lambdas;
+    info.params = params;
+    info.sigmas = sigmas;
+
+    CheckpointPathSink wrapper(sink, checkpoint_file, every, info);
+    gridCCDrFrom(corvec, std::move(betas), sigmas, nn, lambdas, 0, params, verbose, blocks, wrapper);
+}
+
+//
+// resumeGridCCDr
+//
+//   Continue a path from a checkpoint written by checkpointedGridCCDr. The correlations and blocks are not
+//     stored in the checkpoint and must be passed again; everything else (nn, lambdas, params, sigmas and the
+//     warm start) is read from the checkpoint.
+//
+//   The estimates completed before the checkpoint are passed to sink first (with their original stats), followed
+//     by the remaining ones as they are computed, so that sink sees the same sequence as in an uninterrupted run.
+//     Checkpoints keep being written to the same file.
+//
+//   Output: false (after printing a message) if the checkpoint could not be read or does not match corvec/blocks
+//
+//   NOTES:
+//     -the result is bit-identical to an uninterrupted run as long as the same kernel variant is used (a warning
+//       is printed otherwise, see checkpoint.h), also with randomize = true
+//     -a path budget (see gridCCDr) applies to the resumed part of the path only
+//
+bool resumeGridCCDr(const std::string& checkpoint_file,
+                    const std::vector<double>& corvec,
+                    const int verbose,
+                    const BlockList& blocks,
+                    PathSink& sink,
+                    const unsigned int every
+                    ){
+    Checkpoint ckpt;
+    if(!readCheckpoint(checkpoint_file, ckpt)) return false;
+
+    const CheckpointInfo& info = ckpt.info;
+    size_t pp = info.sigmas.size();
+    if(corvec.size() != pp * (pp + 1) / 2 || hashCors(corvec) != info.corsHash){
+        ERROR_OUTPUT << "resumeGridCCDr: The correlations do not match those used to write " << checkpoint_file << "." << std::endl;
+        return false;
+    }
+    if(blocks.size() != info.numBlocks || hashBlocks(blocks) != info.blocksHash){
+        ERROR_OUTPUT << "resumeGridCCDr: The blocks do not match those used to write " << checkpoint_file << "." << std::endl;
+        return false;
+    }
+    if(!ckpt.done && !ckpt.hasWarmStart){
+        ERROR_OUTPUT << "resumeGridCCDr: " << checkpoint_file << " does not contain a warm start." << std::endl;
+        return false;
+    }
+
+    if(info.kernels != kernelVariant()){
+        ERROR_OUTPUT << "resumeGridCCDr: Checkpoint was written using " << info.kernels << " kernels but " << kernelVariant() << " kernels are in use: the resumed path will not be bit-identical." << std::endl;
+    }
+
+    //--- VERBOSE ONLY ---//
+    if(verbose){
+        OUTPUT << "Resuming from " << checkpoint_file << ": " << ckpt.path.size() << " estimates already completed" << std::endl;
+    }
+    //--------------------//
+
+    // Replay the completed estimates
+    for(size_t l = 0; l < ckpt.path.size(); ++l){
+        SparseMatrix est = ckpt.path.materialize(l);
+        sink.consume(est, ckpt.stats[l]);
+    }
+
+    CheckpointPathSink wrapper(sink, checkpoint_file, every, info);
+    wrapper.restore(ckpt.path, ckpt.stats);
+
+    if(ckpt.done){
+        wrapper.finish();
+    } else{
+        gridCCDrFrom(corvec, std::move(ckpt.warmStart), info.sigmas, info.nn, info.lambdas, ckpt.nextLambda, info.params, verbose, blocks, wrapper);
+    }
+
+    return true;
+}
+
+//
+// parallelGridCCDr
+//
+//   Runs the path on several threads. This does NOT give the same estimates as gridCCDr: the grid is split into
+//     'segments' contiguous segments of (nearly) equal length, and each segment is run as an independent path by
+//     one of the threads. The first value of lambda in every segment starts from the initial betas, and the following
+//     ones are warm started from the previous estimate in the same segment. Only the first segment matches gridCCDr;
+//     the others lose the warm start from the preceding segment, which typically changes (and slows down) the
+//     estimates just after each segment boundary.
+//
+//   The estimates are passed to sink in the order of the grid, from the calling thread only, and the path stops
+//     after the first estimate that exceeds the edge threshold, exactly as in gridCCDr. No value of lambda after an
+//     estimate that is known to exceed the threshold is started, in any segment, since it can never be used.
+//
+//   Output: The number of solves and of segments
+//
+//   NOTES:
+//     -the solves run on the shared thread pool (see ThreadPool.h); the calling thread takes part in the solves
+//       while it waits for the next estimate
+//     -deterministic: the estimates depend on 'segments' only, and not on 'threads', the thread cap or the timing
+//       of the threads. With randomize = true, each value of lambda draws its block orders from its own random
+//       number stream (see singleCCDr). The threads take the segments in the order of the grid, so the estimates
+//       that are passed to sink first are also computed first
+//     -an earlier version also had a mode that reproduced gridCCDr exactly by warm starting each value of lambda
+//       from the latest (unverified) estimate and re-solving whenever that guess turned out to differ from the true
+//       warm start. The guess is only right when two consecutive estimates are bit-for-bit identical, which in
+//       practice happens once or twice per path, so that mode did more solves than gridCCDr and was slower
+//     -segments = 0 is treated as 1, and there are never more segments than values of lambda
+//     -falls back to (sequential) gridCCDr when only one segment is used, or when a path budget is set
+//       (params[9..11]); per-lambda budgets are applied to each solve
+//     -verbose output is printed by the calling thread as each estimate is passed to sink
+//     -the packed version only expands corvec into the full correlation matrix and calls the full-matrix version
+//
+ParallelPathStats parallelGridCCDr(const std::vector<double>& corvec,
+                                   const SparseMatrix& betas,
+                                   const std::vector<double>& sigmas,
+                                   const unsigned int nn,
+                                   const std::vector<double>& lambdas,
+                                   const std::vector<double>& params,
+                                   const int verbose,
+                                   const BlockList& blocks,
+                                   PathSink& sink,
+                                   const unsigned int segments,
+                                   const unsigned int threads
+                                   ){
+    Matrix<double> cors = cor_vector_to_Matrix(corvec, betas.dim());
+    return parallelGridCCDr(cors, betas, sigmas, nn, lambdas, params, verbose, blocks, sink, segments, threads);
+}
+
+ParallelPathStats parallelGridCCDr(const Matrix<double>& cors,
+                                   const SparseMatrix& betas,
+                                   const std::vector<double>& sigmas,
+                                   const unsigned int nn,
+                                   const std::vector<double>& lambdas,
+                                   const std::vector<double>& params,
+                                   const int verbose,
+                                   const BlockList& blocks,
+                                   PathSink& sink,
+                                   const unsigned int segments,
+                                   const unsigned int threads
+                                   ){
+    #ifdef _DEBUG_ON_
+        FILE_LOG(logDEBUG2) << "Function call: parallelGridCCDr";
+    #endif
+
+    ParallelPathStats out;
+    out.solves = 0;
+    out.segments = 1;
+
+    int nlam = static_cast<int>(lambdas.size());
+    unsigned int nsegments = std::max(1u, std::min(segments, static_cast<unsigned int>(std::max(nlam, 1))));
+    unsigned int nthreads = resolveThreads(threads, static_cast<int>(nsegments)); // 0 = up to the global thread cap
+
+    if(nsegments <= 1 || !budgetFromParams(params, 9).unlimited()){
+        if(nsegments > 1){
+            ERROR_OUTPUT << "parallelGridCCDr: Path budgets are not supported with segments > 1; running sequentially." << std::endl;
+        }
+
+        CallbackPathSink forward([&sink, &out](const SparseMatrix& b, const LambdaStats& st){ out.solves++; sink.consume(b, st); });
+        gridCCDr(cors, betas, sigmas, nn, lambdas, params, verbose, blocks, forward);
+        sink.finish();
+        return out;
+    }
+
+    typedef std::shared_ptr<const SparseMatrix> MatrixPtr;
+
+    //
+    // Everything below is shared between the threads and protected by mtx
+    //
+    struct Slot{
+        MatrixPtr result;       // finished estimate
+        LambdaStats stats;
+        int breakSize;          // number of edges after the solve (decides early termination as in gridCCDr)
+    };
+
+    std::vector<Slot> slots(nlam);
+    for(int l = 0; l < nlam; ++l) slots[l].breakSize = 0;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    int pendingTasks = 0;   // tasks that have been started but not picked up by a thread yet
+    unsigned int nextSegment = 0;
+    int cutoff = nlam;      // the first estimate known to exceed the edge threshold: nothing after it is used
+    bool stop = false;      // set by the calling thread once the path is done
+    double alpha = params[3];
+
+    WorkBudget lambdaBudget = budgetFromParams(params, 6);
+
+    //
+    // Run one contiguous part of the grid as a path of its own
+    //
+    auto runSegment = [&](int first, int last){
+        SparseMatrix b = betas;
+        for(int l = first; l < last; ++l){
+            {
+                std::lock_guard<std::mutex> guard(mtx);
+                if(stop || l > cutoff) return;
+            }
+
+            Slot done;
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            SolveStatus st = singleCCDr(cors, b, sigmas, nn, lambdas[l], params, 0, blocks, lambdaBudget, l);
+
+            done.stats.index = l;
+            done.stats.lambda = lambdas[l];
+            done.stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            done.stats.iters = st.iters;
+            done.stats.nedges = b.recomputeActiveSetSize(true); // as in gridCCDr, the next warm start sees the reset
+            done.stats.sweeps = st.sweeps;
+            done.stats.evals = st.evals;
+            done.stats.error = st.error;
+            done.stats.status = st.status;
+            done.breakSize = done.stats.nedges;
+            done.result = std::make_shared<const SparseMatrix>(b);
+
+            std::lock_guard<std::mutex> guard(mtx);
+            out.solves++;
+            slots[l] = done;
+            cv.notify_all();
+
+            if(done.breakSize > alpha * betas.dim()){
+                cutoff = std::min(cutoff, l);
+                return;
+            }
+        }
+    };
+
+    // each task runs the segments that have not been taken yet, in order
+    auto segmentTask = [&](){
+        std::unique_lock<std::mutex> lock(mtx);
+        pendingTasks--;
+
+        while(!stop && nextSegment < nsegments){
+            unsigned int t = nextSegment++;
+            int first = static_cast<int>((static_cast<long long>(nlam) * t) / nsegments);
+            int last = static_cast<int>((static_cast<long long>(nlam) * (t + 1)) / nsegments);
+            if(first > cutoff) break;
+
+            lock.unlock();
+            runSegment(first, last);
+            lock.lock();
+        }
+    };
+
+    TaskGroup group;
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        out.segments = nsegments;
+        for(unsigned int t = 0; t < nthreads; ++t){
+            pendingTasks++;
+            group.run(segmentTask);
+        }
+    }
+
+    //--- VERBOSE ONLY ---//
+    if(verbose){
+        OUTPUT << "Using " << kernelVariant() << " numeric kernels, " << nsegments << " segments on " << nthreads << " threads" << std::endl;
+    }
+    //--------------------//
+
+    //
+    // Pass the estimates to sink in order as they become available
+    //
+    for(int l = 0; l < nlam; ++l){
+        MatrixPtr est;
+        LambdaStats st;
+        int breakSize;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            while(!slots[l].result){
+                if(pendingTasks > 0){
+                    // a task is still waiting for a thread: run it here instead of waiting
+                    lock.unlock();
+                    if(!ThreadPool::global().runOne()) std::this_thread::yield();
+                    lock.lock();
+                } else{
+                    cv.wait(lock);
+                }
+            }
+
+            est = slots[l].result;
+            st = slots[l].stats;
+            breakSize = slots[l].breakSize;
+            slots[l].result.reset(); // no longer needed by any segment
+        }
+
+        sink.consume(*est, st);
+
+        //--- VERBOSE ONLY ---//
+        if(verbose){
+            OUTPUT << "Lambda = " << st.lambda << " [" << l+1 << "/" << nlam << "] | " << st.nedges << " edges | iters = " << st.iters;
+            if(st.status != STOP_CONVERGED) OUTPUT << " (stopped: " << stopReasonName(st.status) << ")";
+            OUTPUT << std::endl;
+        }
+        //--------------------//
+
+        if(breakSize > alpha * betas.dim()){
+            break;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        stop = true;
+    }
+    group.wait(); // tasks that have not started yet see stop and return at once
+
+    sink.finish();
+    return out;
+}
+
+//
+// componentGridCCDr
+//
+//   Same as the streaming gridCCDr, but first splits the problem into the connected components of the graph of
+//     blocks (see components.h) and runs an independent path for each component, on several threads. Since no
+//     block joins two components, each component is exactly the same problem as the whole one restricted to its
+//     nodes (up to when singleCCDr stops, see below), and the estimate for each value of lambda is put back together
+//     from the estimates of the components. The components are started in order of decreasing size, each one on
+//     the next free thread of the shared pool (see ThreadPool.h), so that a large component does not end up last.
+//
+//   The edge threshold (alpha) applies to the TOTAL number of edges, as in gridCCDr: each component is run with
+//     the same maximum number of edges (alpha * pp) as the whole problem, and the path is cut after the first value
+//     of lambda at which the components have more than this many edges between them. Components stop as soon as
+//     any value of lambda they have already reached is known to be past the cut.
+//
+//   Output: The number of components
+//
+//   NOTES:
+//     -each component gets exactly the estimates that gridCCDr gives for that component on its own, which are not
+//       always those that gridCCDr gives for the whole problem: singleCCDr stops as soon as a full sweep leaves the
+//       active set unchanged, so in the whole problem a new edge in one component keeps the others iterating too.
+//       The paths have the same length, but the estimates differ slightly, and at small values of lambda they can
+//       land on a different local solution (a few edges apart), so R only uses this when asked to (components = TRUE)
+//     -the two agree exactly when the active sets of all components change at the same sweeps (e.g. identical,
+//       uncorrelated copies of the same component)
+//     -the stats passed to sink add up the time and candidate evaluations of the components and take the largest
+//       number of passes, sweeps and error; the status is that of the worst component
+//     -falls back to gridCCDr when there is only one component, or when a path budget is set (params[9..11]);
+//       per-lambda budgets are applied to each component
+//     -with randomize = true, each component uses the same random number streams as gridCCDr would (one per value
+//       of lambda, see singleCCDr), so the property above still holds and the result does not depend on 'threads'
+//     -the estimates are only passed to sink once every component is done
+//
+unsigned int componentGridCCDr(const Matrix<double>& cors,
+                               const SparseMatrix& betas,
+                               const std::vector<double>& sigmas,
+                               const unsigned int nn,
+                               const std::vector<double>& lambdas,
+                               const std::vector<double>& params,
+                               const int verbose,
+                               const BlockList& blocks,
+                               PathSink& sink,
+                               const unsigned int threads
+                               ){
+    #ifdef _DEBUG_ON_
+        FILE_LOG(logDEBUG2) << "Function call: componentGridCCDr";
+    #endif
+
+    int pp = betas.dim();
+    int nlam = static_cast<int>(lambdas.size());
+    Decomposition dec = decomposeBlocks(blocks, betas);
+    int ncomp = static_cast<int>(dec.nodes.size());
+
+    if(ncomp <= 1 || !budgetFromParams(params, 9).unlimited()){
+        if(ncomp > 1){
+            ERROR_OUTPUT << "componentGridCCDr: Path budgets are not supported with more than one component; solving the whole problem at once." << std::endl;
+        }
+
+        gridCCDr(cors, betas, sigmas, nn, lambdas, params, verbose, blocks, sink);
+        return static_cast<unsigned int>(std::max(ncomp, 1));
+    }
+
+    double alpha = params[3];
+    std::vector<BlockList> localBlocks = splitBlocks(blocks, dec);
+    WorkBudget lambdaBudget = budgetFromParams(params, 6);
+
+    struct ComponentPath{
+        SolutionPath path;
+        std::vector<LambdaStats> stats;
+        std::vector<int> breakSize;     // number of edges after each solve (decides early termination as in gridCCDr)
+    };
+    std::vector<ComponentPath> paths(ncomp);
+
+    // edges found so far for each value of lambda (by the components that have got there), and the last value of
+    //   lambda that can still be part of the path
+    std::vector< std::atomic<int> > edgeSums(nlam);
+    for(int l = 0; l < nlam; ++l) edgeSums[l] = 0;
+    std::atomic<int> lastLambda(nlam - 1);
+
+    unsigned int nthreads = resolveThreads(threads, ncomp);
+
+    //--- VERBOSE ONLY ---//
+    if(verbose){
+        OUTPUT << "Using " << kernelVariant() << " numeric kernels, " << ncomp << " components (largest: " << dec.nodes[0].size() << " nodes), " << nthreads << " threads" << std::endl;
+    }
+    //--------------------//
+
+    forEachNode(ncomp, nthreads, [&](int c){
+        const std::vector<int>& nodes = dec.nodes[c];
+        int pc = static_cast<int>(nodes.size());
+
+        Matrix<double> ccors = subCors(cors, nodes);
+        SparseMatrix b = betas.restrict(nodes);
+
+        // sigmas[0] < 0 is used as a flag to estimate sigmas, so leave sigmas alone in this case
+        std::vector<double> csigmas(pc, -1.);
+        if(sigmas[0] >= 0){
+            for(int k = 0; k < pc; ++k) csigmas[k] = sigmas[nodes[k]];
+        }
+
+        // same maximum number of edges as the whole problem
+        std::vector<double> cparams = params;
+        cparams[3] = alpha * pp / pc;
+
+        ComponentPath& out = paths[c];
+        for(int l = 0; l < nlam && l <= lastLambda; ++l){
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            SolveStatus st = singleCCDr(ccors, b, csigmas, nn, lambdas[l], cparams, 0, localBlocks[c], lambdaBudget, l);
+
+            LambdaStats stats;
+            stats.index = l;
+            stats.lambda = lambdas[l];
+            stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            stats.iters = st.iters;
+            stats.nedges = b.recomputeActiveSetSize(true); // as in gridCCDr, the next warm start sees the reset
+            stats.sweeps = st.sweeps;
+            stats.evals = st.evals;
+            stats.error = st.error;
+            stats.status = st.status;
+
+            out.path.push_back(b, lambdas[l]);
+            out.stats.push_back(stats);
+            out.breakSize.push_back(stats.nedges);
+
+            // the partial sum only grows, so once it passes the threshold, the path ends at l or before
+            int total = (edgeSums[l] += stats.nedges);
+            if(total > alpha * pp){
+                int last = lastLambda;
+                while(l < last && !lastLambda.compare_exchange_weak(last, l)){}
+            }
+        }
+    });
+
+    //
+    // Put the estimates back together and pass them to sink in order
+    //
+    for(int l = 0; l < nlam; ++l){
+        SparseMatrix est(pp);
+        LambdaStats st;
+        st.index = l;
+        st.lambda = lambdas[l];
+        st.seconds = 0;
+        st.iters = 0;
+        st.nedges = 0;
+        st.sweeps = 0;
+        st.evals = 0;
+        st.error = 0;
+        st.status = STOP_CONVERGED;
+        int breakSize = 0;
+
+        bool complete = true;
+        for(int c = 0; c < ncomp; ++c){
+            const ComponentPath& cp = paths[c];
+            if(cp.path.size() <= static_cast<size_t>(l)){
+                complete = false; // only past the end of the path
+                break;
+            }
+
+            est.embed(cp.path.materialize(l), dec.nodes[c]);
+
+            const LambdaStats& cs = cp.stats[l];
+            st.seconds += cs.seconds;
+            st.iters = std::max(st.iters, cs.iters);
+            st.nedges += cs.nedges;
+            st.sweeps = std::max(st.sweeps, cs.sweeps);
+            st.evals += cs.evals;
+            st.error = std::max(st.error, cs.error);
+            if(cs.status > st.status) st.status = cs.status;
+            breakSize += cp.breakSize[l];
+        }
+        if(!complete) break;
+
+        sink.consume(est, st);
+
+        //--- VERBOSE ONLY ---//
+        if(verbose){
+            OUTPUT << "Lambda = " << st.lambda << " [" << l+1 << "/" << nlam << "] | " << st.nedges << " edges | iters = " << st.iters;
+            if(st.status != STOP_CONVERGED) OUTPUT << " (stopped: " << stopReasonName(st.status) << ")";
+            OUTPUT << std::endl;
+        }
+        //--------------------//
 
-        if(betas.activeSetSize() >= alpha * betas.dim()){
+        if(breakSize > alpha * pp){
             break;
         }
     }
 
+    sink.finish();
+    return static_cast<unsigned int>(ncomp);
+}
+
+//
+// ensembleGridCCDr
+//
+//   Runs 'copies' copies of gridCCDr with randomize = true, in parallel on the shared thread pool, and counts how
+//     often each edge is selected for each value of lambda (see EdgeFrequencies in ensemble.h). Copy r is exactly
+//     gridCCDr with params[4] = 1 and params[12] = ensembleSeed(seed, r), where seed is params[12] (0 if missing), so
+//     the result depends on the seed only, and not on the number of threads.
+//
+//   All of the copies share cors and blocks, which are only read: the memory used grows with the number of copies
+//     only through the paths themselves (as flat edge arrays, see EdgeArrays.h), not through the correlations.
+//
+//   Output: The edge counts; the path of each copy is also written to *paths (in EDGES_TRIPLET layout, with 0-based
+//     node indices) unless paths is NULL
+//
+//   NOTES:
+//     -as in R, estimates past the edge threshold (more than alpha * pp edges) are not counted, but they are
+//       included in *paths (as the last estimate of the copy)
+//     -the copies are handed out to the threads one at a time, so copies that stop early do not hold up the others
+//     -verbose only reports when each copy is done (from whichever thread ran it)
+//
+EdgeFrequencies ensembleGridCCDr(const Matrix<double>& cors,
+                                 const SparseMatrix& betas,
+                                 const std::vector<double>& sigmas,
+                                 const unsigned int nn,
+                                 const std::vector<double>& lambdas,
+                                 const std::vector<double>& params,
+                                 const int verbose,
+                                 const BlockList& blocks,
+                                 const unsigned int copies,
+                                 const unsigned int threads,
+                                 std::vector<EdgeArrays>* paths
+                                 ){
+    #ifdef _DEBUG_ON_
+        FILE_LOG(logDEBUG2) << "Function call: ensembleGridCCDr";
+    #endif
+
+    int pp = betas.dim();
+    uint64_t seed = (params.size() > 12) ? static_cast<uint64_t>(params[12]) : 0;
+
+    std::vector<EdgeArrays> out(copies, EdgeArrays(pp, EDGES_TRIPLET, 0));
+    std::mutex outputMtx;
+
+    //--- VERBOSE ONLY ---//
+    if(verbose){
+        OUTPUT << "Using " << kernelVariant() << " numeric kernels, " << copies << " copies, " << resolveThreads(threads, copies) << " threads" << std::endl;
+    }
+    //--------------------//
+
+    forEachNode(static_cast<int>(copies), threads, [&](int r){
+        std::vector<double> cparams = params;
+        if(cparams.size() < 13) cparams.resize(13, 0);
+        cparams[4] = 1;
+        cparams[12] = static_cast<double>(ensembleSeed(seed, static_cast<unsigned int>(r)));
+
+        EdgeArrayPathSink sink(pp, EDGES_TRIPLET, 0);
+        gridCCDr(cors, betas, sigmas, nn, lambdas, cparams, 0, blocks, sink);
+        out[r] = std::move(sink.edges());
+
+        //--- VERBOSE ONLY ---//
+        if(verbose){
+            std::lock_guard<std::mutex> lock(outputMtx);
+            OUTPUT << "Copy " << r+1 << "/" << copies << " done | " << out[r].size() << " estimates" << std::endl;
+        }
+        //--------------------//
+    });
+
+    EdgeFrequencies freq = edgeFrequencies(out, lambdas, params[3] * pp);
+    if(paths) paths->swap(out);
+
+    return freq;
+}
+
+//
+// adaptiveGridCCDr
+//
+//   Runs the path over a coarse grid of lambdas first, and then spends the rest of a fixed budget of fits (calls to
+//     singleCCDr) refining the grid where the path changes quickly. Refinement repeatedly picks the pair of
+//     neighbouring values of lambda with the largest jump, measured relative to the given thresholds as
+//
+//         max(|edges_1 - edges_2| / maxEdgeJump, |obj_1 - obj_2| / |obj_1| / maxObjectiveJump)
+//
+//     and inserts their geometric mean (i.e. the midpoint on the log-scale), warm started from the estimate at the
+//     larger of the two (the neighbour that precedes it along the path). Refinement stops once no jump exceeds its
+//     threshold, or the budget runs out.
+//
+//   Output: The number of fits. The refined path is passed to sink in order of decreasing lambda once refinement is
+//     finished (LambdaStats::index is the position in the refined grid).
+//
+//   NOTES:
+//     -the coarse grid is run exactly as in gridCCDr (including the edge threshold alpha), so refinement never
+//       goes below the first value of lambda that exceeds the threshold
+//     -an inserted estimate is warm started from its upper neighbour, as it would be in gridCCDr over the refined
+//       grid, but its lower neighbour was computed before it was inserted: the path is therefore close to, but
+//       not identical to, the path gridCCDr would compute over the refined grid
+//     -each interval of the coarse grid is halved at most ADAPTIVE_MAX_DEPTH times, so that a single
+//       discontinuity in the path cannot use up the whole budget
+//     -every full estimate (including the sibling index needed to warm start from it) is kept in memory until
+//       refinement is finished
+//
+const int ADAPTIVE_MAX_DEPTH = 6;
+
+unsigned int adaptiveGridCCDr(const std::vector<double>& corvec,
+                              SparseMatrix betas,
+                              const std::vector<double>& sigmas,
+                              const unsigned int nn,
+                              const std::vector<double>& lambdas,
+                              const unsigned int maxFits,
+                              const int maxEdgeJump,
+                              const double maxObjectiveJump,
+                              const std::vector<double>& params,
+                              const int verbose,
+                              const BlockList& blocks,
+                              PathSink& sink
+                              ){
+    #ifdef _DEBUG_ON_
+        FILE_LOG(logDEBUG2) << "Function call: adaptiveGridCCDr";
+    #endif
+
+    struct Fit{
+        SparseMatrix est;
+        LambdaStats stats;
+        double objective;
+        int depth;              // number of times the coarse interval was halved to get here
+    };
+
+    Matrix<double> cors = cor_vector_to_Matrix(corvec, betas.dim());
+    PenaltyFunction MCP = PenaltyFunction(params[0]);
+    WorkBudget budget = budgetFromParams(params, 6);
+    bool profileSigmas = (sigmas[0] < 0);
+    double alpha = params[3];
+    unsigned int numFits = 0;
+
+    // solve for lambda in place, starting from b
+    auto fit = [&](double lambda, SparseMatrix& b, int depth) -> Fit {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        SolveStatus result = singleCCDr(cors, b, sigmas, nn, lambda, params, verbose, blocks, budget, numFits);
+        numFits++;
+        b.recomputeActiveSetSize(true); // as in gridCCDr, the next warm start sees the reset
+
+        Fit f = {b, LambdaStats(), 0., depth};
+        f.stats.index = 0;
+        f.stats.lambda = lambda;
+        f.stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        f.stats.iters = result.iters;
+        f.stats.nedges = b.recomputeActiveSetSize();
+        f.stats.sweeps = result.sweeps;
+        f.stats.evals = result.evals;
+        f.stats.error = result.error;
+        f.stats.status = result.status;
+        f.objective = computeObjective(lambda, nn, b, MCP, cors, profileSigmas);
+
+        //--- VERBOSE ONLY ---//
+        if(verbose){
+            OUTPUT << " | lambda = " << lambda << " | " << f.stats.nedges << " edges" << std::endl;
+        }
+        //--------------------//
+
+        return f;
+    };
+
+    //
+    // Coarse grid: same as gridCCDr
+    //
+    std::vector<Fit> path;
+    for(size_t l = 0; l < lambdas.size() && numFits < maxFits; ++l){
+        path.push_back(fit(lambdas[l], betas, 0));
+
+        if(path.back().stats.nedges > alpha * betas.dim()){
+            break;
+        }
+    }
+
+    //
+    // Refinement: split the interval with the largest jump until every jump is below its threshold
+    //
+    while(numFits < maxFits){
+        int best = -1;
+        double bestScore = 1.;  // a jump has to exceed its threshold to be refined
+
+        for(size_t i = 0; i + 1 < path.size(); ++i){
+            if(std::max(path[i].depth, path[i + 1].depth) >= ADAPTIVE_MAX_DEPTH) continue;
+
+            double score = 0;
+            if(maxEdgeJump > 0){
+                score = std::max(score, std::abs(path[i].stats.nedges - path[i + 1].stats.nedges) / static_cast<double>(maxEdgeJump));
+            }
+            if(maxObjectiveJump > 0){
+                double scale = std::max(fabs(path[i].objective), 1e-12);
+                score = std::max(score, fabs(path[i].objective - path[i + 1].objective) / scale / maxObjectiveJump);
+            }
+
+            if(score > bestScore){
+                bestScore = score;
+                best = static_cast<int>(i);
+            }
+        }
+
+        if(best < 0) break; // the path is smooth enough everywhere
+
+        double lambda = sqrt(path[best].stats.lambda * path[best + 1].stats.lambda);
+        int depth = std::max(path[best].depth, path[best + 1].depth) + 1;
+
+        SparseMatrix b = path[best].est; // warm start from the upper neighbour
+        Fit f = fit(lambda, b, depth);
+        path.insert(path.begin() + best + 1, std::move(f));
+    }
+
+    for(size_t l = 0; l < path.size(); ++l){
+        path[l].stats.index = static_cast<int>(l);
+        sink.consume(path[l].est, path[l].stats);
+    }
+    sink.finish();
+
+    return numFits;
+}
+
+//
+// targetEdgesCCDr
+//
+//   Finds the estimate with (about) targetEdges edges without running a whole path. The search has two phases:
+//
+//   1) Bracketing: starting from maxlam, lambda is decreased by a factor of EDGE_TARGET_STEP at a time (warm
+//        starting from the previous estimate, as in gridCCDr) until the estimate has at least targetEdges edges,
+//        or lambda reaches minlam
+//   2) Bisection: the bracket [lambda_lo, lambda_hi] is narrowed by solving at a point chosen by interpolating the
+//        edge counts at both ends on the log-scale (clamped to the middle half of the bracket, so that the bracket
+//        always shrinks by at least a quarter), warm started from the upper (sparser) end of the bracket
+//
+//   The search stops as soon as an estimate has exactly targetEdges edges, once the bracket is narrower than
+//     EDGE_TARGET_TOL (relative), or once maxFits estimates have been computed.
+//
+//   Output: Every fit computed along the way, and which one is closest to targetEdges (ties go to the larger
+//     value of lambda)
+//
+//   NOTES:
+//     -the number of edges is not always monotone in lambda, so the result is the closest fit found, which is not
+//       necessarily the closest one on the whole path
+//     -targetEdges cannot be reached if it is larger than the edge threshold alpha * pp
+//     -warm starts always come from the larger value of lambda, as in gridCCDr: with a concave penalty, starting
+//       from the denser end tends to keep its edges even when lambda is much larger
+//
+const double EDGE_TARGET_STEP = 0.5;
+const double EDGE_TARGET_TOL = 1e-3;
+
+EdgeTargetResult targetEdgesCCDr(const std::vector<double>& corvec,
+                                 SparseMatrix betas,
+                                 const std::vector<double>& sigmas,
+                                 const unsigned int nn,
+                                 const int targetEdges,
+                                 const double maxlam,
+                                 const double minlam,
+                                 const unsigned int maxFits,
+                                 const std::vector<double>& params,
+                                 const int verbose,
+                                 const BlockList& blocks
+                                 ){
+    #ifdef _DEBUG_ON_
+        FILE_LOG(logDEBUG2) << "Function call: targetEdgesCCDr";
+    #endif
+
+    if(targetEdges > params[3] * betas.dim()){
+        ERROR_OUTPUT << "targetEdgesCCDr: targetEdges = " << targetEdges << " is larger than the edge threshold alpha * pp = " << params[3] * betas.dim() << "." << std::endl;
+    }
+
+    struct Fit{
+        SparseMatrix est;
+        LambdaStats stats;
+    };
+
+    Matrix<double> cors = cor_vector_to_Matrix(corvec, betas.dim());
+    WorkBudget budget = budgetFromParams(params, 6);
+    std::vector<Fit> fits;  // every fit, in the order computed
+
+    // solve for lambda starting from b, and cache the result; returns its index in fits
+    auto fit = [&](double lambda, SparseMatrix b) -> size_t {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        SolveStatus result = singleCCDr(cors, b, sigmas, nn, lambda, params, verbose, blocks, budget, fits.size());
+
+        Fit f = {std::move(b), LambdaStats()};
+        f.stats.index = static_cast<int>(fits.size());
+        f.stats.lambda = lambda;
+        f.stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        f.stats.iters = result.iters;
+        f.stats.nedges = f.est.recomputeActiveSetSize(true); // as in gridCCDr, the next warm start sees the reset
+        f.stats.sweeps = result.sweeps;
+        f.stats.evals = result.evals;
+        f.stats.error = result.error;
+        f.stats.status = result.status;
+        fits.push_back(std::move(f));
+
+        //--- VERBOSE ONLY ---//
+        if(verbose){
+            OUTPUT << " | lambda = " << lambda << " | " << fits.back().stats.nedges << " edges (target " << targetEdges << ")" << std::endl;
+        }
+        //--------------------//
+
+        return fits.size() - 1;
+    };
+
+    //
+    // 1) Bracketing: hi = sparser end (< targetEdges edges), lo = denser end (>= targetEdges edges)
+    //
+    size_t hi = fit(maxlam, std::move(betas));
+    size_t lo = hi;
+    bool bracketed = (fits[hi].stats.nedges >= targetEdges);
+    while(!bracketed && fits.size() < maxFits && fits[hi].stats.lambda > minlam){
+        double lambda = std::max(fits[hi].stats.lambda * EDGE_TARGET_STEP, minlam);
+        size_t next = fit(lambda, fits[hi].est);
+
+        if(fits[next].stats.nedges >= targetEdges){
+            lo = next;
+            bracketed = true;
+        } else{
+            hi = next;
+        }
+    }
+
+    //
+    // 2) Bisection on the log-scale, by interpolating the edge counts
+    //
+    while(bracketed && lo != hi && fits.size() < maxFits){
+        const LambdaStats& shi = fits[hi].stats;
+        const LambdaStats& slo = fits[lo].stats;
+        if(shi.nedges == targetEdges || slo.nedges == targetEdges) break;
+        if(shi.lambda / slo.lambda < 1 + EDGE_TARGET_TOL) break;
+
+        double loghi = log(shi.lambda), loglo = log(slo.lambda);
+        double t = static_cast<double>(targetEdges - shi.nedges) / (slo.nedges - shi.nedges); // 0 => hi, 1 => lo
+        t = std::min(std::max(t, 0.25), 0.75);
+        double lambda = exp(loghi + t * (loglo - loghi));
+
+        size_t next = fit(lambda, fits[hi].est);
+        if(fits[next].stats.nedges >= targetEdges){
+            lo = next;
+        } else{
+            hi = next;
+        }
+    }
+
+    //
+    // Sort the fits by decreasing lambda, and pick the one closest to the target
+    //
+    std::vector<size_t> order(fits.size());
+    for(size_t k = 0; k < order.size(); ++k) order[k] = k;
+    std::sort(order.begin(), order.end(), [&fits](size_t a, size_t b){ return fits[a].stats.lambda > fits[b].stats.lambda; });
+
+    EdgeTargetResult out;
+    out.best = 0;
+    for(size_t k = 0; k < order.size(); ++k){
+        const Fit& f = fits[order[k]];
+        out.fits.push_back(f.est, f.stats.lambda);
+        out.stats.push_back(f.stats);
+
+        if(std::abs(f.stats.nedges - targetEdges) < std::abs(out.stats[out.best].nedges - targetEdges)){
+            out.best = k;
+        }
+    }
+
+    return out;
+}
+
+//
+// reorderedGridCCDr
+//
+//   Same as gridCCDr, but first relabels the nodes using the reverse Cuthill-McKee ordering of the graph defined
+//     by blocks (see reorder.h) in order to improve memory locality when accessing the correlation matrix. The
+//     correlations, blocks, initial betas and sigmas are all permuted before calling gridCCDr, and each estimate
+//     is mapped back to the original node labels before being returned.
+//
+//   Output: A vector of SparseMatrix objects (in the ORIGINAL node labels), one estimate for each value of lambda
+//
+//   NOTES:
+//     -since the order of the blocks is preserved, the estimates are identical to those from gridCCDr
+//     -this is most useful when blocks is sparse (e.g. after screening); with all p(p-1) blocks every ordering
+//       is equally good and the relabeling only costs time
+//
+std::vector<SparseMatrix> reorderedGridCCDr(const std::vector<double>& corvec,
+                                            const SparseMatrix& betas,
+                                            const std::vector<double>& sigmas,
+                                            const unsigned int nn,
+                                            const std::vector<double>& lambdas,
+                                            const std::vector<double>& params,
+                                            const int verbose,
+                                            const BlockList& blocks
+                                            ){
+    unsigned int pp = betas.dim();
+    std::vector<int> perm = rcmOrder(blocks, pp);   // perm[new] = old
+    std::vector<int> inv = invertPermutation(perm); // inv[old] = new
+
+    // sigmas[0] < 0 is used as a flag to estimate sigmas, so leave sigmas alone in this case
+    std::vector<double> psigmas = sigmas;
+    if(sigmas[0] >= 0){
+        for(unsigned int k = 0; k < pp; ++k) psigmas[k] = sigmas[perm[k]];
+    }
+
+    std::vector<SparseMatrix> grid_betas = gridCCDr(permuteCors(corvec, perm),
+                                                    betas.permute(inv),
+                                                    psigmas,
+                                                    nn,
+                                                    lambdas,
+                                                    params,
+                                                    verbose,
+                                                    permuteBlocks(blocks, inv));
+
+    // map the estimates back to the original labels
+    for(size_t l = 0; l < grid_betas.size(); ++l){
+        grid_betas[l] = grid_betas[l].permute(perm);
+    }
+
     return grid_betas;
 }
 
+//
+// reorderedGridCCDr (streaming version, full correlation matrix)
+//
+//   Same as above, but each estimate is mapped back to the original labels and passed to sink as soon as it is
+//     computed, as in the streaming gridCCDr.
+//
+//   NOTES:
+//     -the relabeled correlation matrix is a copy, even if cors is a view
+//
+void reorderedGridCCDr(const Matrix<double>& cors,
+                       const SparseMatrix& betas,
+                       const std::vector<double>& sigmas,
+                       const unsigned int nn,
+                       const std::vector<double>& lambdas,
+                       const std::vector<double>& params,
+                       const int verbose,
+                       const BlockList& blocks,
+                       PathSink& sink
+                       ){
+    unsigned int pp = betas.dim();
+    std::vector<int> perm = rcmOrder(blocks, pp);   // perm[new] = old
+    std::vector<int> inv = invertPermutation(perm); // inv[old] = new
+
+    // sigmas[0] < 0 is used as a flag to estimate sigmas, so leave sigmas alone in this case
+    std::vector<double> psigmas = sigmas;
+    if(sigmas[0] >= 0){
+        for(unsigned int k = 0; k < pp; ++k) psigmas[k] = sigmas[perm[k]];
+    }
+
+    CallbackPathSink relabel([&sink, &perm](const SparseMatrix& b, const LambdaStats& st){ sink.consume(b.permute(perm), st); });
+    gridCCDr(permuteCors(cors, perm),
+             betas.permute(inv),
+             psigmas,
+             nn,
+             lambdas,
+             params,
+             verbose,
+             permuteBlocks(blocks, inv),
+             relabel);
+    sink.finish();
+}
+
 //
 // singleCCDr
 //
@@ -235,23 +1662,61 @@ std::vector<SparseMatrix> gridCCDr(const std::vector<double>& corvec,
 //     -betas and lambda can be anything to start with
 //     -the C++ code enforces no defaults; these are all implemented in R
 //     -it is very important that the params values are passed in the CORRECT ORDER: {gamma, eps, maxIters, alpha}
+//     -params may optionally contain a sixth element, accelDepth: if > 0, Anderson acceleration with this history
+//       depth is applied to the iterations over each fixed active set (see AndersonAccelerator.h)
+//     -params may also contain a per-lambda work budget in params[6..8] = {seconds, passes, evals} (see WorkBudget
+//       in CCDrAlgorithm.h); zero means no limit
+//     -params[12], if present, is the seed for randomize = true (see CounterRNG.h); the default is 0
+//     -betas is taken by value so that callers that no longer need their copy can std::move it in; the work
+//       itself is done in place by the overload below
 //
 SparseMatrix singleCCDr(const std::vector<double>& corvec,
                              SparseMatrix betas,
-                             std::vector<double> sigmas,
+                             const std::vector<double>& sigmas,
                              const unsigned int nn,
                              const double lambda,
                              const std::vector<double>& params,
                              const int verbose,
-                             const BlockList blocks
+                             const BlockList& blocks
                              ){
+    Matrix<double> cors = cor_vector_to_Matrix(corvec, betas.dim());
+    singleCCDr(cors, betas, sigmas, nn, lambda, params, verbose, blocks, budgetFromParams(params, 6));
+
+    return betas;
+}
+
+//
+// singleCCDr (in-place version)
+//
+//   Same as above, but takes the full correlation matrix and overwrites betas with the estimate. This is what
+//     gridCCDr calls for each value of lambda, so that neither the correlation matrix nor betas is rebuilt or
+//     copied between consecutive values of lambda.
+//
+//   The work done is limited by budget (see WorkBudget in CCDrAlgorithm.h): if it runs out, the algorithm stops
+//     immediately (possibly in the middle of a pass) and betas holds a partial estimate.
+//
+//   With randomize = true, the random block orders are drawn from stream number stream of the seed in params[12].
+//     Callers that solve several values of lambda give each one its own stream (gridCCDr uses the index of lambda
+//     in the grid), so that the result for each value does not depend on which thread solved it, or when.
+//
+//   Output: The number of passes, sweeps and candidate evaluations, and why the algorithm stopped (see stopReason)
+//
+SolveStatus singleCCDr(const Matrix<double>& cors,
+                SparseMatrix& betas,
+                const std::vector<double>& sigmas,
+                const unsigned int nn,
+                const double lambda,
+                const std::vector<double>& params,
+                const int verbose,
+                const BlockList& blocks,
+                const WorkBudget& budget,
+                const uint64_t stream
+                ){
     #ifdef _DEBUG_ON_
         FILE_LOG(logDEBUG2) << "Function call: singleCCDr";
         FILE_LOG(logDEBUG1) << "Number of nonzero entries: " << betas.activeSetSize();
     #endif
 
-    Matrix<double> cors = cor_vector_to_Matrix(corvec, betas.dim());
-
     // check if sigmas will be updated
     bool updateSigmasFlag = false;
     if(sigmas[0] < 0){ // < 0 => flag for updating
@@ -266,8 +1731,8 @@ SparseMatrix singleCCDr(const std::vector<double>& corvec,
     //
     // Set parameters for algorithm
     //
-    if(params.size() != 5){
-        OUTPUT << "Parameter vector 'params' should have exactly five elements! Check your input." << std::endl;
+    if(params.size() < 5 || params.size() > 13){
+        OUTPUT << "Parameter vector 'params' should have between five and thirteen elements! Check your input." << std::endl;
     }
 
     double gammaMCP = params[0];  // set parameter for penalty function
@@ -275,6 +1740,8 @@ SparseMatrix singleCCDr(const std::vector<double>& corvec,
     unsigned int maxIters = params[2];
     double alpha = params[3];
     bool randomize = params[4];
+    unsigned int accelDepth = (params.size() > 5) ? params[5] : 0; // 0 = no acceleration
+    uint64_t seed = (params.size() > 12) ? static_cast<uint64_t>(params[12]) : 0;
 
     //
     // Create some critical objects for the algorithm
@@ -286,9 +1753,14 @@ SparseMatrix singleCCDr(const std::vector<double>& corvec,
                                        blocks, 
                                        randomize, 
                                        updateSigmasFlag, 
-                                       LINF // use Linf norm by default (could also use L1)
+                                       LINF, // use Linf norm by default (could also use L1)
+                                       CounterRNG(seed, stream)
     );
     PenaltyFunction MCP = PenaltyFunction(gammaMCP);                        // to compute MCP function
+    AndersonAccelerator accel = AndersonAccelerator(accelDepth);            // optional extrapolation over the active set
+    std::vector<double> xOld, xNew, xAcc;                                   // coefficient vectors used by accel
+    bool innerConverged = true;                                             // did the last pass over the active set converge?
+    CCDR.setBudget(budget);
 
     //
     // Begin the main part of the algorithm
@@ -308,6 +1780,8 @@ SparseMatrix singleCCDr(const std::vector<double>& corvec,
 
         // This pass runs over all blocks
         concaveCDInit(lambda, nn, betas, CCDR, MCP, cors, verbose);
+        CCDR.addIter();
+        CCDR.checkBudget();
 
         //
         // ADD EXTRA ALGORITHM CHECKS HERE IF NEEDED
@@ -318,29 +1792,106 @@ SparseMatrix singleCCDr(const std::vector<double>& corvec,
         if(CCDR.keepGoing()){
             // block for running the rest of the CD iterations over the given active set
             int iters = 1; // we already ran one pass to determine the active set
+            accel.reset(); // the active set has just changed, so any old history is useless
             while( CCDR.moar(iters)){
+                if(accel.enabled()) betas.getValues(xOld);
+
                 concaveCD(lambda, nn, betas, CCDR, MCP, cors, verbose);
+                CCDR.addIter();
                 iters++;
+
+                //
+                // Anderson acceleration: Extrapolate over the last few CD passes and keep the extrapolated
+                //   point only if its objective is no larger than that of the plain CD step it replaces (xNew,
+                //   from this same pass). Edges that were zeroed out by the CD step stay at zero so that the
+                //   active set does not change.
+                //
+                // Comparing against an older objective (e.g. of the last accepted point) is not enough: the CD
+                //   pass in between has already lowered the objective, so an extrapolated point could be accepted
+                //   while being worse than the point it replaces.
+                //
+                // The move to the accepted point is added to the error of the pass, so that the loop only stops
+                //   once the extrapolated point is also within eps of the plain CD step.
+                //
+                if(accel.enabled() && !CCDR.budgetExhausted()){
+                    betas.getValues(xNew);
+                    if(accel.extrapolate(xOld, xNew, xAcc)){
+                        for(size_t i = 0; i < xAcc.size(); ++i){
+                            if(fabs(xNew[i]) <= ZERO_THRESH) xAcc[i] = 0.;
+                        }
+
+                        double objCD = computeObjective(lambda, nn, betas, MCP, cors, CCDR.updateSigmas());
+
+                        moveToValues(betas, CCDR, cors, xAcc);
+                        double objAcc = computeObjective(lambda, nn, betas, MCP, cors, CCDR.updateSigmas());
+
+                        if(objAcc <= objCD){
+                            for(size_t i = 0; i < xAcc.size(); ++i) CCDR.updateError(xAcc[i] - xNew[i]);
+                            accel.accept();
+                        } else{
+                            moveToValues(betas, CCDR, cors, xNew); // safeguard: fall back to the plain CD step
+                            accel.reject();
+                        }
+                    }
+                }
+
+                CCDR.checkBudget();
             }
+
+            innerConverged = (CCDR.getError() <= eps);
         }
 
         // we have finished a full sweep
         CCDR.addSweep();
+        CCDR.checkBudget();
 
     } while( CCDR.keepGoing());
 
+    SolveStatus result;
+    result.iters = CCDR.getIters();
+    result.sweeps = CCDR.getSweeps();
+    result.evals = CCDR.getEvals();
+    result.error = CCDR.getError();
+    if(CCDR.budgetExhausted()){
+        result.status = CCDR.budgetReason();
+    } else if(betas.activeSetSize() > CCDR.edgeThreshold()){
+        result.status = STOP_EDGE_THRESHOLD;
+    } else if(CCDR.getSweeps() > maxIters || !innerConverged){
+        result.status = STOP_MAX_ITERS;
+    } else{
+        result.status = STOP_CONVERGED;
+    }
+
+    //--- VERBOSE ONLY ---//
+    if(verbose){
+        OUTPUT << " | iters = " << CCDR.getIters();
+        if(result.status != STOP_CONVERGED){
+            OUTPUT << " (stopped: " << stopReasonName(result.status) << ")";
+        }
+        if(accel.enabled()){
+            OUTPUT << " (accel: " << accel.numAccepted() << " accepted / " << accel.numRejected() << " rejected)";
+        }
+    }
+    //--------------------//
+
 #ifdef _DEBUG_ON_
     std::ostringstream final_out;
     final_out << "\n\n";
     final_out << "#####################################################\n";
     final_out << "#    Summary                                         \n";
     final_out << "# lambda = " << lambda << std::endl;
+    final_out << "# Numeric kernels: " << kernelVariant() << std::endl;
     final_out << "# Total number of calls to concaveCDInit: " << ccdinit_calls << std::endl;
     final_out << "# Total number of calls to concaveCD: " << ccd_calls << std::endl;
     final_out << "# Total number of calls to checkCycleSparse: " << ccs_calls << std::endl;
     final_out << "# Total number of calls to find: " << find_calls << std::endl;
     final_out << "# Total number of calls to singleUpdate: " << spu_calls << std::endl;
     final_out << "# Total number of calls to singleUpdateV: " << spuV_calls << std::endl;
+    final_out << "# Total number of passes (iterations to eps): " << CCDR.getIters() << std::endl;
+    final_out << "# Total number of candidate evaluations: " << CCDR.getEvals() << std::endl;
+    final_out << "# Stopped because: " << stopReasonName(result.status) << std::endl;
+    final_out << "# Anderson acceleration depth: " << accelDepth << " (" << accel.numAccepted() << " accepted / " << accel.numRejected() << " rejected)" << std::endl;
+    final_out << "# Column buffers from system / pool: " << ColumnPool::local().stats().systemAllocs << " / " << ColumnPool::local().stats().poolHits << std::endl;
     final_out << "#####################################################\n";
     final_out << "\n\n";
 
@@ -348,7 +1899,7 @@ SparseMatrix singleCCDr(const std::vector<double>& corvec,
     FILE_LOG(logINFO) << final_out.str();
 #endif
 
-    return betas;
+    return result;
 }
 
 //
@@ -392,28 +1943,7 @@ void concaveCDInit(const double lambda,
     #endif
 
     if(alg.updateSigmas()){
-        //
-        // Compute sigmas
-        //   See Section 4.2.2. of the computational paper for the details of this calculation
-        //
-        for(unsigned int j = 0; j < betas.dim(); ++j){
-
-            double c = 0;
-            for(unsigned int l = 0; l < betas.rowsizes(j); ++l){
-                unsigned int row = betas.row(j, l);
-
-                c += betas.value(j, l) * cors(j, row); // c += beta_ij * <xj,xi>
-                // if(j <= row){
-                //     c += betas.value(j, l) * cors[(j + row*(row+1)/2)]; // c += beta_ij * <xj,xi>
-                // }
-                // else{
-                //     c += betas.value(j, l) * cors[(row + j*(j+1)/2)];   // c += beta_ij * <xj,xi> (also)
-                // }
-            }
-
-            double s = 0.5 * (1.0 * c + sqrt(c * c + 4 * nn));
-            betas.setSigma(j, s);
-        } // end for loop for sigmas
+        computeSigmas(nn, betas, alg, cors);
     }
 
     #ifdef _DEBUG_ON_
@@ -443,12 +1973,15 @@ void concaveCDInit(const double lambda,
 //    for(unsigned int i = 0; i < pp; ++i){
 //    	for(unsigned int j = i + 1; j < pp; ++j){
 
-            std::vector<int> block = alg.getBlock(k);
-            unsigned int i = block[0];
-            unsigned int j = block[1];
+            if(alg.outOfBudget()) return; // stop in the middle of the sweep: betas is still a valid (acyclic) estimate
+
+            Block block = alg.getBlock(k);
+            unsigned int i = block.row;
+            unsigned int j = block.col;
             // Rcpp::Rcout << "(" << i << "," << j << ")\n";
 
             double betaUpdateij = singleUpdate(i, j, lambda, nn, betas, pen, cors, verbose);
+            alg.addEval();
             bool hasCycleij = false;
 
             // double betaUpdateji = singleUpdate(j, i, lambda, nn, betas, pen, cors, verbose);
@@ -507,6 +2040,7 @@ void concaveCDInit(const double lambda,
                 // }
 
                 err = betas.updateEdge(col, found, betaUpdateij);
+                alg.edgeChanged(col, err * cors(col, row)); // c_col += (new - old) * <xcol,xrow>
 
                 #ifdef _DEBUG_ON_
                     if(betas.dim() <= 5){
@@ -519,6 +2053,7 @@ void concaveCDInit(const double lambda,
                 // only add a block if the update is nonzero
                 if(fabs(betaUpdateij) > ZERO_THRESH){
                     err = betas.addEdge(row, col, betaUpdateij);
+                    alg.edgeChanged(col, err * cors(col, row)); // c_col += (new - 0) * <xcol,xrow>
                     alg.activeSetChanged(); // since we added an edge to the model, the active set has changed
 
                     #ifdef _DEBUG_ON_
@@ -595,27 +2130,7 @@ void concaveCD(const double lambda,
     #endif
 
     if(alg.updateSigmas()){
-        //
-        // Compute sigmas
-        //   See Section 4.2.2. for the details of this calculation
-        //
-        for(unsigned int j = 0; j < betas.dim(); ++j){
-            double c = 0;
-            for(unsigned int l = 0; l < betas.rowsizes(j); ++l){
-                unsigned int row = betas.row(j, l);
-
-                c += betas.value(j, l) * cors(j, row); // c += beta_ij * <xj,xi>
-                // if(j <= row){
-                //     c += betas.value(j, l) * cors[(j + row*(row+1)/2)]; // c += beta_ij * <xj,xi>
-                // }
-                // else{
-                //     c += betas.value(j, l) * cors[(row + j*(j+1)/2)];   // c += beta_ij * <xj,xi> (also)
-                // }
-            }
-
-            double s = 0.5 * (1.0 * c + sqrt(c * c + 4 * nn));
-            betas.setSigma(j, s);
-        } // end for loop for sigmas
+        computeSigmas(nn, betas, alg, cors);
     }
 
     #ifdef _DEBUG_ON_
@@ -630,6 +2145,8 @@ void concaveCD(const double lambda,
 
     unsigned int pp = betas.dim();
     for(unsigned int j = 0; j < pp; ++j){
+        if(alg.outOfBudget()) return; // checked once per column, since most columns have few (or no) parents
+
     	for(unsigned int rowIdx = 0; rowIdx < betas.rowsizes(j); ++rowIdx){
             unsigned int i = betas.row(j, rowIdx); // get the row from the sparse structure
 
@@ -657,6 +2174,7 @@ void concaveCD(const double lambda,
             // only update the nonzero edge
             if(fabs(betakj) > ZERO_THRESH){
                 betaUpdateij = singleUpdate(i, j, lambda, nn, betas, pen, cors, verbose);
+                alg.addEval();
             }
             // else if(fabs(betajk) > ZERO_THRESH){
             //     betaUpdateji = singleUpdate(j, i, lambda, nn, betas, pen, cors, verbose);
@@ -666,6 +2184,7 @@ void concaveCD(const double lambda,
             // Update the edge weights no matter what below -- if a block is "zeroed-out" this is ok
             //
             double err = betas.updateEdge(j, rowIdx, betaUpdateij);
+            alg.edgeChanged(j, err * cors(j, i)); // c_j += (new - old) * <xj,xi>
 
             //
             // Update the accumulated error
@@ -739,16 +2258,9 @@ double singleUpdate(const unsigned int a,
     // }
 
     // Subtract the terms \phi_ij <xi,xk>
-    for(unsigned int i = 0; i < betas.rowsizes(b); ++i){
-        unsigned int row = betas.row(b, i);
-        if(row != a) res_ab -= cors(row, a) * betas.value(b, i);
-        // if(row < a){
-        //     res_ab -= cors[(row + a*(a+1)/2)] * betas.value(b, i);
-        // }
-        // else if(row > a){ // i=a is excluded
-        //     res_ab -= cors[(a + row*(row+1)/2)] * betas.value(b, i);
-        // }
-    }
+    //   This is a gather over column a of cors at the parents of b (excluding a itself), and is the hottest
+    //   loop in the algorithm: see kernels.h for the (vectorized) implementations
+    res_ab -= gatherDot(cors.colptr(a), betas.rowptr(b), betas.valptr(b), betas.rowsizes(b), a);
 
     //
     // The SPU is given by S_gamma(res_ab, lambda), aka evaluating the threshold function
@@ -764,6 +2276,123 @@ double singleUpdate(const unsigned int a,
     return betaUpdate;
 }
 
+//
+// computeSigmas
+//
+//   Update the residual parameters (sigmas). See Section 4.2.2. of the computational paper for the details of
+//     this calculation: sigma_j = (c_j + sqrt(c_j^2 + 4n)) / 2, where c_j = sum_i beta_ij * <xj,xi>.
+//
+//   Only columns whose betas have changed since the last call are updated (see the sigma cache in
+//     CCDrAlgorithm.h); c_j is maintained incrementally by concaveCDInit / concaveCD. If the cache has been
+//     invalidated, every c_j is recomputed from scratch.
+//
+//   Input: Note that betas & alg are all passed (and hence updated) by reference (hence void)
+//   Output: void
+//
+void computeSigmas(const unsigned int nn,
+                   SparseMatrix& betas,
+                   CCDrAlgorithm& alg,
+                   const Matrix<double>& cors
+                   ){
+    bool recompute = !alg.sigmaCacheValid();
+
+    for(unsigned int j = 0; j < betas.dim(); ++j){
+        if(!recompute && !alg.sigmaChanged(j)) continue; // nothing in this column has changed
+
+        double c = 0;
+        if(recompute){
+            // c = sum_i beta_ij * <xj,xi>, a gather over column j of cors at the parents of j
+            c = gatherDot(cors.colptr(j), betas.rowptr(j), betas.valptr(j), betas.rowsizes(j), -1);
+        } else{
+            c = alg.sigmaInnerProd(j);
+        }
+        alg.setSigmaInnerProd(j, c);
+
+        double s = 0.5 * (1.0 * c + sqrt(c * c + 4 * nn));
+        betas.setSigma(j, s);
+    } // end for loop for sigmas
+
+    if(recompute) alg.validateSigmaCache();
+}
+
+//
+// moveToValues
+//
+//   Move betas to the values in x (as produced by SparseMatrix::getValues on the same active set) one edge at a
+//     time, through the same updateEdge / edgeChanged calls as concaveCD, so that the active set bookkeeping and
+//     the sigma cache stay in sync with the new values. Used to apply (or undo) an Anderson extrapolation step.
+//
+//   NOTES:
+//     -the error of the pass is left alone: it is up to the caller to decide whether the move counts
+//
+void moveToValues(SparseMatrix& betas,
+                  CCDrAlgorithm& alg,
+                  const Matrix<double>& cors,
+                  const std::vector<double>& x
+                  ){
+    size_t idx = 0;
+    for(int j = 0; j < betas.dim(); ++j){
+        for(int k = 0; k < betas.rowsizes(j); ++k){
+            double err = betas.updateEdge(j, k, x[idx++]);
+            alg.edgeChanged(j, err * cors(j, betas.row(j, k))); // c_j += (new - old) * <xj,xi>
+        }
+    }
+}
+
+//
+// computeObjective
+//
+//   Compute the value of the penalized negative log-likelihood at the current value of betas (and sigmas):
+//
+//      sum_j { -n * log(sigma_j) + 0.5 * ||sigma_j * x_j - X * beta_j||^2 + sum_i p_lambda(|beta_ij|) }
+//
+//     where the squared norm is expanded in terms of the inner products stored in cors. This is the same
+//     objective that each single parameter update minimizes coordinatewise (cf. the commented-out
+//     computeEdgeLoss below). Currently only used to safeguard Anderson acceleration in singleCCDr.
+//
+//   If profileSigmas = true, each sigma_j is replaced by its minimizer given beta_j (the same closed form used
+//     to update sigmas in concaveCDInit), so that the objective only depends on betas. This is the appropriate
+//     comparison whenever sigmas are being estimated, since they are re-estimated at the start of every pass.
+//
+//   Output: The value of the objective function
+//
+double computeObjective(const double lambda,
+                        const unsigned int nn,
+                        const SparseMatrix& betas,
+                        const PenaltyFunction& pen,
+                        const Matrix<double>& cors,
+                        const bool profileSigmas
+                        ){
+    double obj = 0;
+
+    for(int j = 0; j < betas.dim(); ++j){
+        double c = 0;       // c = sum_i beta_ij * <xj,xi>
+        double quad = 0;    // quad = ||X * beta_j||^2
+        double penalty = 0;
+
+        for(int m = 0; m < betas.rowsizes(j); ++m){
+            double bm = betas.value(j, m);
+            if(fabs(bm) <= ZERO_THRESH) continue;
+
+            unsigned int row_m = betas.row(j, m);
+            c += cors(row_m, j) * bm;
+            for(int n = 0; n < betas.rowsizes(j); ++n){
+                quad += cors(row_m, betas.row(j, n)) * bm * betas.value(j, n);
+            }
+
+            penalty += pen.p(fabs(bm), lambda);
+        }
+
+        double sigma = profileSigmas ? 0.5 * (c + sqrt(c * c + 4 * nn)) : betas.sigma(j);
+        double loss = sigma * sigma * cors(j, j) - 2.0 * sigma * c + quad;
+
+        if(sigma > 0) obj -= nn * log(sigma);
+        obj += 0.5 * loss + penalty;
+    }
+
+    return obj;
+}
+
 //
 // computeEdgeLoss
 //
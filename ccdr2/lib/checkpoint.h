@@ -0,0 +1,449 @@
+//
+//  checkpoint.h
+//  ccdr2
+//
+
+#ifndef checkpoint_h
+#define checkpoint_h
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+
+#include "SparseMatrix.h"
+#include "SolutionPath.h"
+#include "BlockList.h"
+#include "PathSink.h"
+
+//------------------------------------------------------------------------------/
+//   CHECKPOINTING FOR LONG PATHS
+//------------------------------------------------------------------------------/
+
+//
+// A checkpoint contains everything needed to continue a gridCCDr run exactly where it left off:
+//
+//   1) the inputs that are cheap to store (nn, lambdas, params, sigmas), along with hashes of the inputs that
+//       are not (the correlations and the BlockList), so that a resumed run can check it is given the same data
+//   2) the index of the next value of lambda to compute, and the warm start for it (i.e. the current estimate,
+//       stored exactly, see SparseMatrix::writeBinary)
+//   3) every estimate completed so far, with its LambdaStats; columns that are unchanged from the previous
+//       estimate are stored as a one-byte flag
+//   4) the numeric kernel variant in use (see kernels.h): different variants round differently, so a run resumed
+//       on a machine with a different variant is not bit-identical (a warning is printed in this case)
+//
+// The order of the BlockList is part of the input (each value of lambda starts again from the given order), so
+//   it is covered by the BlockList hash. Randomized runs (randomize = true) are resumed bit-identically too: the
+//   seed is part of params, and each value of lambda draws from its own stream (see singleCCDr), so nothing
+//   else about the random numbers needs to be stored.
+//
+// Checkpoints are written to <file>.tmp and then renamed over <file>, so a job that is killed while writing
+//   always leaves the previous checkpoint intact. The file ends with a checksum of everything before it, and a
+//   file that is truncated, has a bad checksum or contains an out-of-range size or index is rejected as a whole.
+//
+// File layout (native-endian):
+//
+//   char magic[8] = "CCDRCKP3", int nextLambda, int done, int nn, int numBlocks,
+//   uint64 corsHash, uint64 blocksHash, string kernels, vector lambdas, vector params, vector sigmas,
+//   int hasWarmStart, [SparseMatrix warmStart], int numEntries, entries
+//
+//   where string = int n, char[n]; vector = int n, double[n]; and each entry is
+//
+//   LambdaStats (index, lambda, seconds, iters, nedges, sweeps, evals, error, int status), double sigmas[pp],
+//   then for each column: char flag (0 = empty, 1 = same as previous entry, 2 = stored), [int n, int rows[n], double vals[n]]
+//
+//   followed by uint64 checksum (hashBytes of every byte before it, including the magic)
+//
+
+const char CHECKPOINT_MAGIC[8] = {'C', 'C', 'D', 'R', 'C', 'K', 'P', '3'};
+
+//
+// CheckpointInfo
+//
+//   The inputs to gridCCDr recorded in each checkpoint
+//
+struct CheckpointInfo{
+    unsigned int nn;
+    unsigned int numBlocks;
+    unsigned long long corsHash;
+    unsigned long long blocksHash;
+    std::string kernels;
+    std::vector<double> lambdas;
+    std::vector<double> params;
+    std::vector<double> sigmas;
+};
+
+//
+// Checkpoint
+//
+//   The contents of a checkpoint file, as returned by readCheckpoint
+//
+struct Checkpoint{
+    CheckpointInfo info;
+    unsigned int nextLambda;            // index of the next value of lambda to compute
+    bool done;                          // true if the path had already finished
+    bool hasWarmStart;
+    SparseMatrix warmStart;             // estimate to start from at lambdas[nextLambda]
+    SolutionPath path;                  // completed estimates
+    std::vector<LambdaStats> stats;     // stats for the completed estimates
+
+    Checkpoint() : nextLambda(0), done(false), hasWarmStart(false), warmStart(0){}
+};
+
+//
+// Hashing (64-bit FNV-1a), used to check that a resumed run is given the same inputs
+//
+unsigned long long hashBytes(const void* data, size_t n, unsigned long long h = 14695981039346656037ULL){
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for(size_t i = 0; i < n; ++i){
+        h ^= bytes[i];
+        h *= 1099511628211ULL;
+    }
+
+    return h;
+}
+
+unsigned long long hashCors(const std::vector<double>& corvec){
+    return hashBytes(corvec.data(), corvec.size() * sizeof(double));
+}
+
+unsigned long long hashBlocks(const BlockList& blocks){
+    return hashBytes(blocks.data(), 2 * static_cast<size_t>(blocks.size()) * sizeof(int));
+}
+
+//
+// Low-level binary I/O helpers
+//
+template<class T>
+void writeValue(std::FILE* f, const T& x){
+    std::fwrite(&x, sizeof(T), 1, f);
+}
+
+template<class T>
+bool readValue(std::FILE* f, T& x){
+    return std::fread(&x, sizeof(T), 1, f) == 1;
+}
+
+void writeDoubles(std::FILE* f, const std::vector<double>& v){
+    int n = static_cast<int>(v.size());
+    writeValue(f, n);
+    std::fwrite(v.data(), sizeof(double), n, f);
+}
+
+// Check that the next 'count' items of 'size' bytes each lie before 'end', so that a corrupt length cannot
+//  trigger a huge allocation
+bool fitsBefore(std::FILE* f, long end, long long count, size_t size){
+    long pos = std::ftell(f);
+    return pos >= 0 && count >= 0 && count <= (end - pos) / static_cast<long long>(size);
+}
+
+bool readDoubles(std::FILE* f, std::vector<double>& v, long end){
+    int n = 0;
+    if(!readValue(f, n) || !fitsBefore(f, end, n, sizeof(double))) return false;
+    v.resize(n);
+    return std::fread(v.data(), sizeof(double), n, f) == static_cast<size_t>(n);
+}
+
+void writeLambdaStats(std::FILE* f, const LambdaStats& st){
+    writeValue(f, st.index);
+    writeValue(f, st.lambda);
+    writeValue(f, st.seconds);
+    writeValue(f, st.iters);
+    writeValue(f, st.nedges);
+    writeValue(f, st.sweeps);
+    writeValue(f, st.evals);
+    writeValue(f, st.error);
+    writeValue(f, static_cast<int>(st.status));
+}
+
+// Hash the first n bytes of f (see hashBytes), leaving f positioned after them
+bool hashFile(std::FILE* f, long n, unsigned long long& h){
+    char buf[1 << 14];
+    h = hashBytes(NULL, 0);
+    if(std::fseek(f, 0, SEEK_SET) != 0) return false;
+
+    while(n > 0){
+        size_t chunk = (n < static_cast<long>(sizeof(buf))) ? static_cast<size_t>(n) : sizeof(buf);
+        if(std::fread(buf, 1, chunk, f) != chunk) return false;
+        h = hashBytes(buf, chunk, h);
+        n -= static_cast<long>(chunk);
+    }
+
+    return true;
+}
+
+bool readLambdaStats(std::FILE* f, LambdaStats& st){
+    int status = 0;
+    bool ok = readValue(f, st.index) && readValue(f, st.lambda) && readValue(f, st.seconds)
+           && readValue(f, st.iters) && readValue(f, st.nedges) && readValue(f, st.sweeps)
+           && readValue(f, st.evals) && readValue(f, st.error) && readValue(f, status);
+    st.status = static_cast<stopReason>(status);
+
+    return ok;
+}
+
+//
+// writeCheckpoint
+//
+//   Write a checkpoint atomically (via a temporary file and rename). warmStart may be NULL if there is nothing
+//     left to compute. Returns false if the file could not be written.
+//
+bool writeCheckpoint(const std::string& file_name,
+                     const CheckpointInfo& info,
+                     unsigned int nextLambda,
+                     bool done,
+                     const SparseMatrix* warmStart,
+                     const SolutionPath& path,
+                     const std::vector<LambdaStats>& stats){
+    std::string tmp_name = file_name + ".tmp";
+    std::FILE* f = std::fopen(tmp_name.c_str(), "w+b");   // read back below to compute the checksum
+    if(f == NULL){
+        ERROR_OUTPUT << "writeCheckpoint: Could not open " << tmp_name << " for writing." << std::endl;
+        return false;
+    }
+
+    std::fwrite(CHECKPOINT_MAGIC, 1, sizeof(CHECKPOINT_MAGIC), f);
+    writeValue(f, static_cast<int>(nextLambda));
+    writeValue(f, static_cast<int>(done));
+    writeValue(f, static_cast<int>(info.nn));
+    writeValue(f, static_cast<int>(info.numBlocks));
+    writeValue(f, info.corsHash);
+    writeValue(f, info.blocksHash);
+    writeValue(f, static_cast<int>(info.kernels.size()));
+    std::fwrite(info.kernels.data(), 1, info.kernels.size(), f);
+    writeDoubles(f, info.lambdas);
+    writeDoubles(f, info.params);
+    writeDoubles(f, info.sigmas);
+
+    writeValue(f, static_cast<int>(warmStart != NULL));
+    if(warmStart != NULL) warmStart->writeBinary(f);
+
+    int pp = path.dim();
+    writeValue(f, static_cast<int>(path.size()));
+    for(size_t l = 0; l < path.size(); ++l){
+        writeLambdaStats(f, stats[l]);
+        for(int j = 0; j < pp; ++j){
+            double s = path.sigma(l, j);
+            writeValue(f, s);
+        }
+
+        for(int j = 0; j < pp; ++j){
+            int n = path.rowsizes(l, j);
+            char flag = (n == 0) ? 0 : (path.sharedWithPrevious(l, j) ? 1 : 2);
+            writeValue(f, flag);
+
+            if(flag == 2){
+                writeValue(f, n);
+                std::fwrite(path.rowptr(l, j), sizeof(int), n, f);
+                std::fwrite(path.valptr(l, j), sizeof(double), n, f);
+            }
+        }
+    }
+
+    // Checksum everything written so far and append it
+    unsigned long long checksum = 0;
+    long size = std::ftell(f);
+    bool ok = (std::ferror(f) == 0) && size >= 0 && std::fflush(f) == 0 && hashFile(f, size, checksum);
+    ok = ok && std::fseek(f, 0, SEEK_END) == 0;
+    if(ok) writeValue(f, checksum);
+
+    ok = ok && (std::ferror(f) == 0);
+    ok = (std::fclose(f) == 0) && ok;
+    if(!ok){
+        ERROR_OUTPUT << "writeCheckpoint: Error while writing " << tmp_name << "." << std::endl;
+        std::remove(tmp_name.c_str());
+        return false;
+    }
+
+    if(std::rename(tmp_name.c_str(), file_name.c_str()) != 0){
+        // rename does not replace an existing file on some platforms (e.g. Windows)
+        std::remove(file_name.c_str());
+        if(std::rename(tmp_name.c_str(), file_name.c_str()) != 0){
+            ERROR_OUTPUT << "writeCheckpoint: Could not rename " << tmp_name << " to " << file_name << "." << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//
+// readCheckpoint
+//
+//   Read a checkpoint written by writeCheckpoint into out. Returns false (after printing a message) if the file
+//     is missing, truncated, corrupt or not a checkpoint. The checksum is verified before anything is parsed,
+//     and every size and index is still checked against the file and against pp while parsing.
+//
+bool readCheckpoint(const std::string& file_name, Checkpoint& out){
+    std::FILE* f = std::fopen(file_name.c_str(), "rb");
+    if(f == NULL){
+        ERROR_OUTPUT << "readCheckpoint: Could not open " << file_name << "." << std::endl;
+        return false;
+    }
+
+    // The payload is everything before the trailing checksum
+    long end = -1;
+    if(std::fseek(f, 0, SEEK_END) == 0) end = std::ftell(f) - static_cast<long>(sizeof(unsigned long long));
+
+    bool ok = end >= static_cast<long>(sizeof(CHECKPOINT_MAGIC));
+    unsigned long long checksum = 0, stored = 0;
+    ok = ok && hashFile(f, end, checksum) && readValue(f, stored) && stored == checksum;
+    ok = ok && std::fseek(f, 0, SEEK_SET) == 0;
+
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    ok = ok && std::fread(magic, 1, sizeof(magic), f) == sizeof(magic);
+    ok = ok && std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0;
+
+    int nextLambda = 0, done = 0, nn = 0, numBlocks = 0, nk = 0, hasWarmStart = 0, numEntries = 0;
+    ok = ok && readValue(f, nextLambda) && readValue(f, done) && readValue(f, nn) && readValue(f, numBlocks);
+    ok = ok && nn >= 0 && numBlocks >= 0;
+    ok = ok && readValue(f, out.info.corsHash) && readValue(f, out.info.blocksHash);
+    ok = ok && readValue(f, nk) && nk >= 0 && nk < 256;
+    if(ok){
+        std::vector<char> k(nk);
+        ok = std::fread(k.data(), 1, nk, f) == static_cast<size_t>(nk);
+        out.info.kernels.assign(k.begin(), k.end());
+    }
+    ok = ok && readDoubles(f, out.info.lambdas, end) && readDoubles(f, out.info.params, end) && readDoubles(f, out.info.sigmas, end);
+    ok = ok && nextLambda >= 0 && static_cast<size_t>(nextLambda) <= out.info.lambdas.size();
+
+    // The warm start must have the same dimension as sigmas, which resumeGridCCDr checks against the correlations
+    int pp = static_cast<int>(out.info.sigmas.size());
+    ok = ok && readValue(f, hasWarmStart);
+    if(ok && hasWarmStart) ok = out.warmStart.readBinary(f, pp);
+
+    out.nextLambda = nextLambda;
+    out.done = (done != 0);
+    out.hasWarmStart = (hasWarmStart != 0);
+    out.info.nn = nn;
+    out.info.numBlocks = numBlocks;
+
+    // Completed estimates: rebuild each one from the previous and push it onto the path
+    ok = ok && readValue(f, numEntries) && numEntries >= 0 && static_cast<size_t>(numEntries) <= out.info.lambdas.size();
+    SparseMatrix cur(pp);
+    std::vector<int> rows;
+    std::vector<double> vals;
+    for(int l = 0; ok && l < numEntries; ++l){
+        LambdaStats st;
+        ok = readLambdaStats(f, st);
+
+        for(int j = 0; ok && j < pp; ++j){
+            double s = 0;
+            ok = readValue(f, s);
+            cur.setSigma(j, s);
+        }
+
+        for(int j = 0; ok && j < pp; ++j){
+            char flag = 0;
+            ok = readValue(f, flag);
+            if(!ok) break;
+
+            if(flag == 0){
+                cur.setColumn(j, NULL, NULL, 0);
+            } else if(flag == 2){
+                int n = 0;
+                ok = readValue(f, n) && n >= 0 && n <= pp;
+                if(!ok) break;
+
+                rows.resize(n);
+                vals.resize(n);
+                ok = std::fread(rows.data(), sizeof(int), n, f) == static_cast<size_t>(n)
+                  && std::fread(vals.data(), sizeof(double), n, f) == static_cast<size_t>(n);
+                for(int k = 0; ok && k < n; ++k){
+                    ok = rows[k] >= 0 && rows[k] < pp;
+                }
+                if(ok) cur.setColumn(j, rows.data(), vals.data(), n);
+            } else{
+                // flag == 1: column is unchanged from the previous entry (so there must be one)
+                ok = (flag == 1) && l > 0;
+            }
+        }
+
+        if(ok){
+            out.path.push_back(cur, st.lambda);
+            out.stats.push_back(st);
+        }
+    }
+
+    // Nothing may be left over between the last entry and the checksum
+    ok = ok && std::ftell(f) == end;
+
+    std::fclose(f);
+
+    if(!ok){
+        ERROR_OUTPUT << "readCheckpoint: " << file_name << " is not a valid checkpoint file (or is truncated or corrupt)." << std::endl;
+    }
+
+    return ok;
+}
+
+//
+// CheckpointPathSink
+//
+//   Wraps another PathSink: every estimate is forwarded to the inner sink and also recorded, and a checkpoint
+//     is written after every 'every' values of lambda, as well as once the path is finished.
+//
+//   NOTE: Each checkpoint rewrites the completed estimates in full, so for very long paths 'every' should be
+//         chosen so that checkpointing is cheap compared to the time between checkpoints.
+//
+class CheckpointPathSink : public PathSink{
+
+public:
+    CheckpointPathSink(PathSink& in_inner, const std::string& in_file, unsigned int in_every, const CheckpointInfo& in_info);
+
+    void consume(const SparseMatrix& betas, const LambdaStats& stats);
+    void finish();
+    void restore(const SolutionPath& in_path, const std::vector<LambdaStats>& in_stats); // continue from a checkpoint
+    unsigned int numWritten() const;    // number of checkpoints written so far
+
+private:
+    PathSink& inner;
+    std::string file_name;
+    unsigned int every;
+    CheckpointInfo info;
+
+    SolutionPath path;
+    std::vector<LambdaStats> stats_;
+    unsigned int sinceLast;             // number of estimates since the last checkpoint
+    unsigned int written;
+};
+
+CheckpointPathSink::CheckpointPathSink(PathSink& in_inner,
+                                       const std::string& in_file,
+                                       unsigned int in_every,
+                                       const CheckpointInfo& in_info)
+    : inner(in_inner), file_name(in_file), every(in_every), info(in_info), sinceLast(0), written(0){
+    if(every == 0) every = 1;
+}
+
+void CheckpointPathSink::consume(const SparseMatrix& betas, const LambdaStats& stats){
+    inner.consume(betas, stats);
+
+    path.push_back(betas, stats.lambda);
+    stats_.push_back(stats);
+
+    // betas is the warm start for the next value of lambda
+    if(++sinceLast >= every){
+        if(writeCheckpoint(file_name, info, stats.index + 1, false, &betas, path, stats_)) written++;
+        sinceLast = 0;
+    }
+}
+
+void CheckpointPathSink::finish(){
+    if(writeCheckpoint(file_name, info, static_cast<unsigned int>(info.lambdas.size()), true, NULL, path, stats_)) written++;
+    inner.finish();
+}
+
+// The estimates completed before a resume are part of every later checkpoint; they are NOT forwarded to the
+//   inner sink (see resumeGridCCDr)
+void CheckpointPathSink::restore(const SolutionPath& in_path, const std::vector<LambdaStats>& in_stats){
+    path = in_path;
+    stats_ = in_stats;
+    sinceLast = 0;
+}
+
+unsigned int CheckpointPathSink::numWritten() const{
+    return written;
+}
+
+#endif
@@ -0,0 +1,190 @@
+//
+//  components.h
+//  ccdr2
+//
+
+#ifndef components_h
+#define components_h
+
+#include <vector>
+#include <algorithm>
+
+#include "Matrix.h"
+#include "SparseMatrix.h"
+#include "BlockList.h"
+
+//------------------------------------------------------------------------------/
+//   CONNECTED COMPONENTS OF THE SCREENING GRAPH
+//------------------------------------------------------------------------------/
+
+//
+// The CCDr objective is a sum over nodes, and a node can only have parents among the nodes it shares a block with.
+//   If the (undirected) graph of the blocks splits into several connected components, the problem therefore splits
+//   exactly into one independent problem per component, and no cycle can go through two components. The functions
+//   below find the components, and cut the correlations, blocks and warm start down to each one (see
+//   componentGridCCDr in algorithm.h).
+//
+// NOTES:
+//   -the edges of the warm start (betas) are added to the graph, so that every stored edge lies within a component
+//   -nodes that belong to no block (and no edge) are bundled into a single group, rather than one problem each
+//   -the groups are sorted by decreasing size, so that the largest problems are started first
+//
+
+//
+// UnionFind
+//
+//   Disjoint sets over 0, ..., n-1, with path halving and union by size
+//
+class UnionFind{
+
+public:
+    UnionFind(int n);
+
+    int find(int x);
+    void unite(int x, int y);
+
+private:
+    std::vector<int> parent;
+    std::vector<int> size;
+};
+
+UnionFind::UnionFind(int n){
+    parent.resize(n);
+    size.resize(n, 1);
+    for(int x = 0; x < n; ++x) parent[x] = x;
+}
+
+int UnionFind::find(int x){
+    while(parent[x] != x){
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+
+    return x;
+}
+
+void UnionFind::unite(int x, int y){
+    x = find(x);
+    y = find(y);
+    if(x == y) return;
+
+    if(size[x] < size[y]) std::swap(x, y);
+    parent[y] = x;
+    size[x] += size[y];
+}
+
+struct Decomposition{
+    std::vector< std::vector<int> > nodes;  // nodes of each group, in increasing order
+    std::vector<int> group;                 // group of each node
+    std::vector<int> local;                 // position of each node within its group
+};
+
+Decomposition decomposeBlocks(const BlockList& blocks, const SparseMatrix& betas);
+Matrix<double> subCors(const Matrix<double>& cors, const std::vector<int>& nodes);
+std::vector<BlockList> splitBlocks(const BlockList& blocks, const Decomposition& dec);
+
+//
+// decomposeBlocks
+//
+//   Output: The connected components of the graph of blocks (and edges of betas), largest first, with the isolated
+//     nodes bundled together
+//
+Decomposition decomposeBlocks(const BlockList& blocks, const SparseMatrix& betas){
+    int pp = betas.dim();
+
+    UnionFind uf(pp);
+    std::vector<bool> touched(pp, false);
+    for(unsigned int k = 0; k < blocks.size(); ++k){
+        Block bl = blocks.getBlock(k);
+        uf.unite(bl.row, bl.col);
+        touched[bl.row] = touched[bl.col] = true;
+    }
+    for(int j = 0; j < pp; ++j){
+        for(int k = 0; k < betas.rowsizes(j); ++k){
+            uf.unite(betas.row(j, k), j);
+            touched[betas.row(j, k)] = touched[j] = true;
+        }
+    }
+
+    // one group per root (in order of the smallest node), plus one for all of the isolated nodes
+    std::vector<int> rootGroup(pp, -1);
+    std::vector< std::vector<int> > groups;
+    std::vector<int> isolated;
+    for(int j = 0; j < pp; ++j){
+        if(!touched[j]){
+            isolated.push_back(j);
+            continue;
+        }
+
+        int r = uf.find(j);
+        if(rootGroup[r] < 0){
+            rootGroup[r] = static_cast<int>(groups.size());
+            groups.push_back(std::vector<int>());
+        }
+        groups[rootGroup[r]].push_back(j);
+    }
+    if(!isolated.empty()) groups.push_back(isolated);
+
+    std::stable_sort(groups.begin(), groups.end(),
+                     [](const std::vector<int>& a, const std::vector<int>& b){ return a.size() > b.size(); });
+
+    Decomposition dec;
+    dec.nodes = std::move(groups);
+    dec.group.resize(pp);
+    dec.local.resize(pp);
+    for(size_t c = 0; c < dec.nodes.size(); ++c){
+        for(size_t k = 0; k < dec.nodes[c].size(); ++k){
+            dec.group[dec.nodes[c][k]] = static_cast<int>(c);
+            dec.local[dec.nodes[c][k]] = static_cast<int>(k);
+        }
+    }
+
+    return dec;
+}
+
+//
+// subCors
+//
+//   The correlations between the given nodes only (node nodes[k] becomes node k)
+//
+Matrix<double> subCors(const Matrix<double>& cors, const std::vector<int>& nodes){
+    size_t n = nodes.size();
+
+    Matrix<double> out(n, n);
+    for(size_t b = 0; b < n; ++b){
+        const double* col = cors.colptr(nodes[b]);
+        for(size_t a = 0; a < n; ++a){
+            out(a, b) = col[nodes[a]];
+        }
+    }
+
+    return out;
+}
+
+//
+// splitBlocks
+//
+//   The blocks of each group, in local labels and in the same order as in blocks, so that each group is visited
+//     in the same order as in the whole problem
+//
+std::vector<BlockList> splitBlocks(const BlockList& blocks, const Decomposition& dec){
+    size_t ngroups = dec.nodes.size();
+
+    std::vector< std::vector<int> > pairs(ngroups);
+    for(unsigned int k = 0; k < blocks.size(); ++k){
+        Block bl = blocks.getBlock(k);
+        std::vector<int>& p = pairs[dec.group[bl.col]];
+        p.push_back(dec.local[bl.row]);
+        p.push_back(dec.local[bl.col]);
+    }
+
+    std::vector<BlockList> out;
+    out.reserve(ngroups);
+    for(size_t c = 0; c < ngroups; ++c){
+        out.push_back(BlockList(pairs[c], static_cast<unsigned int>(dec.nodes[c].size())));
+    }
+
+    return out;
+}
+
+#endif
@@ -25,9 +25,10 @@ std::vector<std::string> reorder(const std::vector<std::string> x, const std::ve
 
 // uses Matrix.h
 template<class T> Matrix<T> cor_vector_to_Matrix(const std::vector<T>& cors, unsigned int ncol);
-template<class T> std::vector<T> max_entry_by_column(Matrix<T> &cors);
-template<class T> std::vector<size_t> getNodeOrder(Matrix<T> cors);
-template<class T> void printSymmetricMatrix(Matrix<T> m);
+template<class T> Matrix<T> cor_vector_to_Matrix(const T* cors, unsigned int ncol);
+template<class T> std::vector<T> max_entry_by_column(const Matrix<T>& cors);
+template<class T> std::vector<size_t> getNodeOrder(const Matrix<T>& cors);
+template<class T> void printSymmetricMatrix(const Matrix<T>& m);
 
 // from http://stackoverflow.com/a/12399290/3961092
 template <typename T>
@@ -56,6 +57,12 @@ std::vector<std::string> reorder(const std::vector<std::string> x, const std::ve
 // --- MATRIX.H ------------------------------------------------------------------------
 template<class T>
 Matrix<T> cor_vector_to_Matrix(const std::vector<T>& cors, unsigned int ncol){
+    return cor_vector_to_Matrix(cors.data(), ncol);
+}
+
+// same as above, for packed correlations owned by someone else (e.g. an R vector), without copying them first
+template<class T>
+Matrix<T> cor_vector_to_Matrix(const T* cors, unsigned int ncol){
 
     Matrix<T> cormat(ncol, ncol);
     for(unsigned j = 0; j < ncol; ++j) // columns first
@@ -67,7 +74,7 @@ Matrix<T> cor_vector_to_Matrix(const std::vector<T>& cors, unsigned int ncol){
 }
 
 template<class T>
-std::vector<T> max_entry_by_column(Matrix<T> &cors){
+std::vector<T> max_entry_by_column(const Matrix<T>& cors){
     std::vector<T> maxcor(cors.ncol());
     for(auto j = 0; j < cors.ncol(); ++j){
         maxcor[j] = 0;
@@ -85,13 +92,13 @@ std::vector<T> max_entry_by_column(Matrix<T> &cors){
 }
 
 template<class T>
-std::vector<size_t> getNodeOrder(Matrix<T> cors){
+std::vector<size_t> getNodeOrder(const Matrix<T>& cors){
     auto maxcor = max_entry_by_column(cors);
     return order(maxcor);
 }
 
 template<class T>
-void printSymmetricMatrix(Matrix<T> m){
+void printSymmetricMatrix(const Matrix<T>& m){
     // printf ("floats: %4.2f %+.0e %E \n", 3.1416, 3.1416, 3.1416);
     for (unsigned i = 0; i < m.nrow(); ++i){
         for (unsigned j = 0; j < m.ncol(); ++j){
@@ -0,0 +1,103 @@
+//
+//  ensemble.h
+//  ccdr2
+//
+
+#ifndef ensemble_h
+#define ensemble_h
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+#include "CounterRNG.h"
+#include "EdgeArrays.h"
+
+//------------------------------------------------------------------------------/
+//   RANDOMIZED-ORDER ENSEMBLES
+//------------------------------------------------------------------------------/
+
+//
+// With randomize = true, the block order changes the local solution that CCDr finds. An ensemble runs several
+//   copies of the path, each with its own random block orders, and counts how often each edge is selected for each
+//   value of lambda (see ensembleGridCCDr in algorithm.h). The functions below derive the seed of each copy and
+//   count the edges.
+//
+
+//
+// EdgeFrequencies
+//
+//   For each value of lambda, the edges selected by at least one copy, in triplet form (see EdgeArrays): the edges
+//     of the lth value of lambda are entries [offsets[l], offsets[l+1]) of rows / cols / counts, sorted by column
+//     (child), then by row (parent). nfits[l] is the number of copies with an estimate for lambda l, so that the
+//     selection frequency of an edge is counts[k] / nfits[l].
+//
+struct EdgeFrequencies{
+    std::vector<double> lambdas;
+    std::vector<int> nfits;
+    std::vector<size_t> offsets;
+    std::vector<int> rows;
+    std::vector<int> cols;
+    std::vector<int> counts;
+};
+
+uint64_t ensembleSeed(uint64_t seed, unsigned int copy);
+EdgeFrequencies edgeFrequencies(const std::vector<EdgeArrays>& paths, const std::vector<double>& lambdas, double maxEdges);
+
+//
+// ensembleSeed
+//
+//   The seed (params[12]) used by copy number 'copy' of an ensemble started with the given seed. The seeds are
+//     hashed rather than consecutive, so that ensembles started from neighbouring seeds do not share copies. Only
+//     53 bits are kept, so that the seed can be passed in params (a vector of doubles) exactly.
+//
+uint64_t ensembleSeed(uint64_t seed, unsigned int copy){
+    CounterRNG rng(seed, copy);
+    return rng.next() >> 11;
+}
+
+//
+// edgeFrequencies
+//
+//   Counts the edges of each value of lambda over the paths of the copies (EDGES_TRIPLET layout, any base). As in R,
+//     estimates with more than maxEdges edges (i.e. past the edge threshold) are not counted.
+//
+EdgeFrequencies edgeFrequencies(const std::vector<EdgeArrays>& paths, const std::vector<double>& lambdas, double maxEdges){
+    EdgeFrequencies out;
+    out.offsets.push_back(0);
+
+    std::vector< std::pair<int, int> > edges; // (col, row), so that sorting gives the order of EdgeArrays
+    for(size_t l = 0; l < lambdas.size(); ++l){
+        int nfits = 0;
+        edges.clear();
+        for(size_t r = 0; r < paths.size(); ++r){
+            const EdgeArrays& p = paths[r];
+            if(p.size() <= l || p.nedges[l] > maxEdges) continue;
+
+            nfits++;
+            for(size_t k = p.offsets[l]; k < p.offsets[l + 1]; ++k) edges.push_back(std::make_pair(p.cols[k], p.rows[k]));
+        }
+
+        // no copy got this far: the rest of the path is empty as well
+        if(nfits == 0) break;
+
+        std::sort(edges.begin(), edges.end());
+        for(size_t k = 0; k < edges.size(); ){
+            size_t next = k + 1;
+            while(next < edges.size() && edges[next] == edges[k]) ++next;
+
+            out.rows.push_back(edges[k].second);
+            out.cols.push_back(edges[k].first);
+            out.counts.push_back(static_cast<int>(next - k));
+            k = next;
+        }
+
+        out.lambdas.push_back(lambdas[l]);
+        out.nfits.push_back(nfits);
+        out.offsets.push_back(out.rows.size());
+    }
+
+    return out;
+}
+
+#endif
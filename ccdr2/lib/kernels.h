@@ -0,0 +1,223 @@
+//
+//  kernels.h
+//  ccdr2
+//
+
+#ifndef kernels_h
+#define kernels_h
+
+#include <string>
+#include <stdlib.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define _CCDR_X86_KERNELS_
+    #include <immintrin.h>
+#endif
+
+//------------------------------------------------------------------------------/
+//   NUMERIC KERNELS FOR THE CCDR ALGORITHM
+//------------------------------------------------------------------------------/
+
+//
+// This file collects the hot numeric routines used by the CCDr code, each of which comes in several variants:
+//
+//   1) scalar : The reference implementation; plain loops that any compiler / CPU can handle
+//   2) avx2   : 4-wide AVX2 + FMA
+//   3) avx512 : 8-wide AVX-512
+//
+// The vectorized variants are compiled with function-level target attributes, so the rest of the code does NOT
+//   need to be compiled with -mavx2 / -march=native, and a single build runs on any x86-64 machine. The first
+//   time any kernel is requested (see kernels()), the widest variant supported by the CPU is selected via CPUID
+//   and recorded in a KernelTable. On anything other than x86 with GCC/Clang only the scalar variants exist.
+//
+// The selection can be capped by setting the environment variable CCDR_KERNELS to "scalar" or "avx2" before the
+//   first call (e.g. for testing, or to reproduce results from an older machine); it can never be raised above
+//   what the CPU supports.
+//
+// The kernels are:
+//
+//   gatherDot      : sum_{k : idx[k] != skip} col[idx[k]] * vals[k]  (singleUpdate, sigma updates)
+//
+// All variants compute the same quantity, but the vectorized versions sum the terms in a different order (and
+//   use fused multiply-adds), so their results may differ from the scalar version in the last few bits. This is
+//   why a checkpoint records the variant in use (see checkpoint.h).
+//
+
+typedef double (*GatherDotFn)(const double* col, const int* idx, const double* vals, int n, int skip);
+
+struct KernelTable{
+    std::string name;                   // name of the selected variant (scalar / avx2 / avx512)
+    GatherDotFn gatherDot;
+};
+
+const int GATHER_PREFETCH_DISTANCE = 16; // how many parents ahead to prefetch correlation entries
+
+//------------------------------------------------------------------------------/
+//   SCALAR (REFERENCE) KERNELS
+//------------------------------------------------------------------------------/
+
+double gatherDotScalar(const double* col, const int* idx, const double* vals, int n, int skip){
+    double sum = 0;
+    for(int k = 0; k < n; ++k){
+        if(idx[k] != skip) sum += col[idx[k]] * vals[k];
+    }
+
+    return sum;
+}
+
+#ifdef _CCDR_X86_KERNELS_
+//------------------------------------------------------------------------------/
+//   AVX2 KERNELS
+//------------------------------------------------------------------------------/
+
+__attribute__((target("avx2,fma")))
+double hsumAVX2(__m256d acc){
+    __m128d lo = _mm256_castpd256_pd128(acc);
+    __m128d hi = _mm256_extractf128_pd(acc, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+}
+
+__attribute__((target("avx2,fma")))
+double gatherDotAVX2(const double* col, const int* idx, const double* vals, int n, int skip){
+    __m256d acc = _mm256_setzero_pd();
+    __m128i vskip = _mm_set1_epi32(skip);
+    const __m256d vall = _mm256_castsi256_pd(_mm256_set1_epi64x(-1)); // gather all four lanes
+
+    int k = 0;
+    for(; k + 4 <= n; k += 4){
+        // prefetch the correlation entries needed a few iterations from now
+        if(k + GATHER_PREFETCH_DISTANCE + 4 <= n){
+            const int* pf = idx + k + GATHER_PREFETCH_DISTANCE;
+            _mm_prefetch(reinterpret_cast<const char*>(col + pf[0]), _MM_HINT_T0);
+            _mm_prefetch(reinterpret_cast<const char*>(col + pf[1]), _MM_HINT_T0);
+            _mm_prefetch(reinterpret_cast<const char*>(col + pf[2]), _MM_HINT_T0);
+            _mm_prefetch(reinterpret_cast<const char*>(col + pf[3]), _MM_HINT_T0);
+        }
+
+        __m128i vidx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(idx + k));
+        __m256d c = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), col, vidx, vall, 8);
+        __m256d v = _mm256_loadu_pd(vals + k);
+
+        // zero out the term with idx == skip (if any) instead of branching on it
+        __m256d drop = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_cmpeq_epi32(vidx, vskip)));
+        v = _mm256_andnot_pd(drop, v);
+
+        acc = _mm256_fmadd_pd(c, v, acc);
+    }
+
+    double sum = hsumAVX2(acc);
+    for(; k < n; ++k){
+        if(idx[k] != skip) sum += col[idx[k]] * vals[k];
+    }
+
+    return sum;
+}
+
+//------------------------------------------------------------------------------/
+//   AVX-512 KERNELS
+//------------------------------------------------------------------------------/
+
+//
+// The intrinsics below are picked so that every lane has a defined source (explicit zeros, or zero-masking),
+//   instead of the unspecified register that _mm512_reduce_add_pd and friends start from: gcc 12 warns about
+//   those with -Wmaybe-uninitialized.
+//
+__attribute__((target("avx512f")))
+double hsumAVX512(__m512d acc){
+    __m256d lo = _mm512_maskz_extractf64x4_pd(0xF, acc, 0);
+    __m256d hi = _mm512_maskz_extractf64x4_pd(0xF, acc, 1);
+    return hsumAVX2(_mm256_add_pd(lo, hi));
+}
+
+__attribute__((target("avx512f")))
+double gatherDotAVX512(const double* col, const int* idx, const double* vals, int n, int skip){
+    __m512d acc = _mm512_setzero_pd();
+    __m512i vskip = _mm512_set1_epi64(skip);
+
+    int k = 0;
+    for(; k + 8 <= n; k += 8){
+        if(k + GATHER_PREFETCH_DISTANCE + 8 <= n){
+            const int* pf = idx + k + GATHER_PREFETCH_DISTANCE;
+            for(int t = 0; t < 8; ++t){
+                _mm_prefetch(reinterpret_cast<const char*>(col + pf[t]), _MM_HINT_T0);
+            }
+        }
+
+        __m256i vidx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx + k));
+        __mmask8 keep = _mm512_cmpneq_epi64_mask(_mm512_maskz_cvtepi32_epi64(0xFF, vidx), vskip);
+        __m512d c = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), keep, vidx, col, 8);
+        __m512d v = _mm512_loadu_pd(vals + k);
+
+        acc = _mm512_fmadd_pd(c, v, acc);
+    }
+
+    double sum = hsumAVX512(acc);
+    for(; k < n; ++k){
+        if(idx[k] != skip) sum += col[idx[k]] * vals[k];
+    }
+
+    return sum;
+}
+
+#endif
+
+//------------------------------------------------------------------------------/
+//   DISPATCH
+//------------------------------------------------------------------------------/
+
+//
+// selectKernels
+//
+//   Use CPUID to build the table of the widest kernels supported by the current processor, capped by the
+//     CCDR_KERNELS environment variable if it is set.
+//
+KernelTable selectKernels(){
+    KernelTable kt;
+    kt.name = "scalar";
+    kt.gatherDot = &gatherDotScalar;
+
+#ifdef _CCDR_X86_KERNELS_
+    const char* cap = getenv("CCDR_KERNELS");
+    std::string maxVariant = (cap == NULL) ? "avx512" : std::string(cap);
+    if(maxVariant == "scalar") return kt;
+
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")){
+        kt.name = "avx2";
+        kt.gatherDot = &gatherDotAVX2;
+
+        if(maxVariant == "avx2") return kt;
+    }
+    if(__builtin_cpu_supports("avx512f")){
+        kt.name = "avx512";
+        kt.gatherDot = &gatherDotAVX512;
+    }
+#endif
+
+    return kt;
+}
+
+//
+// kernels
+//
+//   Returns the table of kernels for this machine; the table is built on the first call
+//
+const KernelTable& kernels(){
+    static KernelTable kt = selectKernels();
+    return kt;
+}
+
+// name of the selected variant, for reporting
+std::string kernelVariant(){
+    return kernels().name;
+}
+
+//
+// Convenience wrapper used by the algorithm
+//
+double gatherDot(const double* col, const int* idx, const double* vals, int n, int skip){
+    return kernels().gatherDot(col, idx, vals, n, skip);
+}
+
+#endif
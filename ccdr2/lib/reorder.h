@@ -0,0 +1,170 @@
+//
+//  reorder.h
+//  ccdr2
+//
+
+#ifndef reorder_h
+#define reorder_h
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+#include "Matrix.h"
+#include "SparseMatrix.h"
+#include "BlockList.h"
+
+//------------------------------------------------------------------------------/
+//   NODE RELABELING FOR MEMORY LOCALITY
+//------------------------------------------------------------------------------/
+
+//
+// The correlation lookups in singleUpdate follow the parent indices of each node, which in the original
+//   probe order look essentially random. For large problems (where the correlation matrix is several GB),
+//   this means that almost every lookup is a cache miss (and often a TLB miss).
+//
+// The functions below relabel the nodes so that nodes that are likely to be parents of one another (i.e. nodes
+//   that appear together in the BlockList) get nearby labels. We use the reverse Cuthill-McKee (RCM) ordering of
+//   the undirected graph defined by the BlockList, which is a standard bandwidth-reducing ordering: after
+//   relabeling, the nonzero entries of the adjacency matrix of the screening graph cluster near the diagonal, so
+//   the gathered correlation entries tend to share cache lines and pages.
+//
+// Relabeling does not change the algorithm: the BlockList is permuted entry by entry (its ORDER is preserved),
+//   so the sequence of updates is exactly the same as without relabeling, and the estimates are mapped back to
+//   the original node labels before they are returned.
+//
+// Convention: perm[new] = old, i.e. node perm[k] in the original labeling is node k after relabeling.
+//
+
+std::vector<int> rcmOrder(const BlockList& blocks, unsigned int pp);
+std::vector<int> invertPermutation(const std::vector<int>& perm);
+std::vector<double> permuteCors(const std::vector<double>& corvec, const std::vector<int>& perm);
+Matrix<double> permuteCors(const Matrix<double>& cors, const std::vector<int>& perm);
+BlockList permuteBlocks(const BlockList& blocks, const std::vector<int>& inv);
+
+//
+// rcmOrder
+//
+//   Computes the reverse Cuthill-McKee ordering of the (undirected) graph whose edges are the blocks in the
+//     BlockList. Each connected component is traversed by BFS starting from a node of minimum degree, visiting
+//     neighbours in order of increasing degree; the concatenated BFS order is then reversed.
+//
+//   Output: perm, with perm[new] = old
+//
+std::vector<int> rcmOrder(const BlockList& blocks, unsigned int pp){
+    // Build the (symmetrized) adjacency lists of the screening graph
+    std::vector< std::vector<int> > adj(pp);
+    for(unsigned int k = 0; k < blocks.size(); ++k){
+        Block bl = blocks.getBlock(k);
+        if(bl.row == bl.col) continue;
+
+        adj[bl.row].push_back(bl.col);
+        adj[bl.col].push_back(bl.row);
+    }
+
+    std::vector<int> degree(pp);
+    for(unsigned int j = 0; j < pp; ++j){
+        std::sort(adj[j].begin(), adj[j].end());
+        adj[j].erase(std::unique(adj[j].begin(), adj[j].end()), adj[j].end());
+        degree[j] = static_cast<int>(adj[j].size());
+    }
+    for(unsigned int j = 0; j < pp; ++j){
+        std::stable_sort(adj[j].begin(), adj[j].end(), [&degree](int a, int b){ return degree[a] < degree[b]; });
+    }
+
+    // Candidate starting nodes, by increasing degree
+    std::vector<int> byDegree(pp);
+    for(unsigned int j = 0; j < pp; ++j) byDegree[j] = j;
+    std::stable_sort(byDegree.begin(), byDegree.end(), [&degree](int a, int b){ return degree[a] < degree[b]; });
+
+    std::vector<int> perm;
+    perm.reserve(pp);
+    std::vector<bool> visited(pp, false);
+    std::deque<int> queue;
+
+    for(unsigned int s = 0; s < pp; ++s){
+        int start = byDegree[s];
+        if(visited[start]) continue;
+
+        visited[start] = true;
+        queue.push_back(start);
+        while(!queue.empty()){
+            int node = queue.front();
+            queue.pop_front();
+            perm.push_back(node);
+
+            for(size_t l = 0; l < adj[node].size(); ++l){
+                int nb = adj[node][l];
+                if(!visited[nb]){
+                    visited[nb] = true;
+                    queue.push_back(nb);
+                }
+            }
+        }
+    }
+
+    std::reverse(perm.begin(), perm.end());
+
+    return perm;
+}
+
+// inv[old] = new
+std::vector<int> invertPermutation(const std::vector<int>& perm){
+    std::vector<int> inv(perm.size());
+    for(size_t k = 0; k < perm.size(); ++k) inv[perm[k]] = static_cast<int>(k);
+
+    return inv;
+}
+
+//
+// permuteCors
+//
+//   Relabel the packed (upper-triangular) correlation vector: the new (a, b) entry is the old
+//     (perm[a], perm[b]) entry.
+//
+std::vector<double> permuteCors(const std::vector<double>& corvec, const std::vector<int>& perm){
+    size_t pp = perm.size();
+    std::vector<double> out(corvec.size());
+
+    for(size_t j = 0; j < pp; ++j){
+        for(size_t i = 0; i <= j; ++i){
+            size_t lo = std::min(perm[i], perm[j]);
+            size_t hi = std::max(perm[i], perm[j]);
+            out[i + j*(j+1)/2] = corvec[lo + hi*(hi+1)/2];
+        }
+    }
+
+    return out;
+}
+
+// Same for the full correlation matrix: the new (a, b) entry is the old (perm[a], perm[b]) entry. The result
+//  is always a copy, even if cors is a view
+Matrix<double> permuteCors(const Matrix<double>& cors, const std::vector<int>& perm){
+    size_t pp = perm.size();
+    Matrix<double> out(pp, pp);
+
+    for(size_t b = 0; b < pp; ++b){
+        const double* col = cors.colptr(perm[b]);
+        for(size_t a = 0; a < pp; ++a) out(a, b) = col[perm[a]];
+    }
+
+    return out;
+}
+
+//
+// permuteBlocks
+//
+//   Relabel every block (i, j) -> (inv[i], inv[j]), keeping the blocks in the same order
+//
+BlockList permuteBlocks(const BlockList& blocks, const std::vector<int>& inv){
+    std::vector<int> out(2 * blocks.size());
+    for(unsigned int k = 0; k < blocks.size(); ++k){
+        Block bl = blocks.getBlock(k);
+        out[2*k] = inv[bl.row];
+        out[2*k + 1] = inv[bl.col];
+    }
+
+    return BlockList(out, blocks.nodes);
+}
+
+#endif
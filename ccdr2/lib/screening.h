@@ -0,0 +1,406 @@
+//
+//  screening.h
+//  ccdr2
+//
+
+#ifndef screening_h
+#define screening_h
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+#include "Matrix.h"
+#include "BlockList.h"
+#include "penalties.h"
+#include "ThreadPool.h"
+
+//------------------------------------------------------------------------------/
+//   SCREENING GRAPHS
+//------------------------------------------------------------------------------/
+
+//
+// Builds the screening graph (i.e. the BlockList of candidate edges) directly from the correlation matrix. Each
+//   node first picks its own neighbourhood, and i and j are neighbours if i was picked for j (and/or j for i, see
+//   screenRule). Two ways of picking neighbourhoods:
+//
+//   -neighbourhood selection (Meinshausen and Buhlmann, 2006): each node is regressed on all of the others with a
+//     lasso penalty (see neighbourhoodLasso)
+//   -marginal screening: each node keeps its k most correlated partners, and/or every partner whose correlation
+//     is above a threshold (see marginalNeighbourhoods); much cheaper, and gives about k*p candidate edges
+//
+// Both work on the standardized entries
+//
+//     r_kl = cors(k, l) / sqrt(cors(k, k) * cors(l, l)),
+//
+//   so that lambda / the threshold are on the same (scale-free) scale as a correlation. Every node is handled
+//   independently, and the nodes are split between the threads of the shared pool (see forEachNode in ThreadPool.h).
+//
+// The output is grouped by column: for each node j, in the requested order, the pairs
+//   (i, j) for every neighbour i of j. Like allBlocks in R, each neighbouring pair appears once in each direction.
+//
+enum screenRule {SCREEN_AND, SCREEN_OR};
+
+const int SCREEN_MAX_SWEEPS = 1000;
+const double SCREEN_TOL = 1e-6;
+
+std::vector< std::vector<int> > neighbourhoodLasso(const Matrix<double>& cors, double lambda, unsigned int threads);
+std::vector< std::vector<int> > marginalNeighbourhoods(const Matrix<double>& cors, int k, double threshold, unsigned int threads);
+std::vector<int> symmetrizeNeighbourhoods(std::vector< std::vector<int> > nbhd, screenRule rule, const std::vector<int>& order);
+std::vector<int> screenPairs(const Matrix<double>& cors, double lambda, screenRule rule, unsigned int threads, const std::vector<int>& order);
+std::vector<int> marginalScreenPairs(const Matrix<double>& cors, int k, double threshold, screenRule rule, unsigned int threads, const std::vector<int>& order);
+BlockList screenBlocks(const Matrix<double>& cors, double lambda, screenRule rule, unsigned int threads, const std::vector<int>& order);
+BlockList marginalScreenBlocks(const Matrix<double>& cors, int k, double threshold, screenRule rule, unsigned int threads, const std::vector<int>& order);
+
+//
+// inverseSds
+//
+//   1 / sqrt(cors(k, k)) for each node, or 0 for a constant node (which is then never anyone's neighbour)
+//
+std::vector<double> inverseSds(const Matrix<double>& cors){
+    std::vector<double> invsd(cors.ncol());
+    for(size_t k = 0; k < invsd.size(); ++k){
+        double d = cors(k, k);
+        invsd[k] = (d > 0) ? 1.0 / sqrt(d) : 0;
+    }
+
+    return invsd;
+}
+
+//
+// lassoNeighbours
+//
+//   Lasso regression of node j on all of the other nodes, in terms of the correlations only:
+//
+//     minimize (1/2) b' R b - r_j' b + lambda * |b|_1,   b_j = 0
+//
+//   Coordinate descent keeps the gradient g = r_j - R b up to date for every coordinate, so that a full sweep
+//     (to look for new nonzero coefficients) costs O(p), and each update of a coefficient costs O(p). Sweeps over
+//     the active set alternate with full sweeps until a full sweep changes nothing.
+//
+//   Output: The nodes with nonzero coefficients, in increasing order
+//
+std::vector<int> lassoNeighbours(const Matrix<double>& cors, const std::vector<double>& invsd, int j, double lambda){
+    int pp = static_cast<int>(cors.ncol());
+    std::vector<double> b(pp, 0), g(pp);
+    std::vector<int> active;
+
+    const double* cj = cors.colptr(j);
+    for(int k = 0; k < pp; ++k) g[k] = cj[k] * invsd[k] * invsd[j];
+
+    // set b_k to the lasso solution given the others, and update the gradient; returns the size of the change
+    auto update = [&](int k) -> double {
+        double bk = LassoThreshold(g[k] + b[k], lambda); // r_kk = 1
+        double delta = bk - b[k];
+        if(delta == 0) return 0;
+
+        if(b[k] == 0) active.push_back(k);
+        b[k] = bk;
+
+        const double* ck = cors.colptr(k);
+        double sk = delta * invsd[k];
+        for(int l = 0; l < pp; ++l) g[l] -= ck[l] * invsd[l] * sk;
+
+        return fabs(delta);
+    };
+
+    for(int sweep = 0; sweep < SCREEN_MAX_SWEEPS; ++sweep){
+        // full sweep
+        double maxDelta = 0;
+        for(int k = 0; k < pp; ++k){
+            if(k == j || invsd[k] == 0) continue;
+            maxDelta = std::max(maxDelta, update(k));
+        }
+        if(maxDelta < SCREEN_TOL) break;
+
+        // active set sweeps
+        for(int inner = 0; inner < SCREEN_MAX_SWEEPS; ++inner){
+            maxDelta = 0;
+            for(size_t a = 0; a < active.size(); ++a){
+                maxDelta = std::max(maxDelta, update(active[a]));
+            }
+            if(maxDelta < SCREEN_TOL) break;
+        }
+    }
+
+    std::vector<int> out;
+    for(int k = 0; k < pp; ++k){
+        if(b[k] != 0) out.push_back(k);
+    }
+
+    return out;
+}
+
+//
+// neighbourhoodLasso
+//
+//   Runs lassoNeighbours for every node, using the given number of threads (0 = as many as the thread cap allows)
+//
+//   Output: The (unsymmetrized) neighbourhood of each node
+//
+std::vector< std::vector<int> > neighbourhoodLasso(const Matrix<double>& cors, double lambda, unsigned int threads){
+    int pp = static_cast<int>(cors.ncol());
+    std::vector<double> invsd = inverseSds(cors);
+
+    std::vector< std::vector<int> > nbhd(pp);
+    forEachNode(pp, threads, [&](int j){
+        if(invsd[j] > 0) nbhd[j] = lassoNeighbours(cors, invsd, j, lambda);
+    });
+
+    return nbhd;
+}
+
+//
+// marginalNeighbourhoods
+//
+//   For each node j, the partners i with |r_ij| > threshold, keeping only the k largest if k > 0 (threshold = 0
+//     and k > 0 is plain top-k). The k largest are found by partial selection (std::nth_element), so each column
+//     costs O(p) rather than a full sort; ties are broken towards the smaller index, so the result does not
+//     depend on the number of threads.
+//
+//   Output: The (unsymmetrized) neighbourhood of each node, in increasing order
+//
+std::vector< std::vector<int> > marginalNeighbourhoods(const Matrix<double>& cors, int k, double threshold, unsigned int threads){
+    int pp = static_cast<int>(cors.ncol());
+    std::vector<double> invsd = inverseSds(cors);
+
+    std::vector< std::vector<int> > nbhd(pp);
+    forEachNode(pp, threads, [&](int j){
+        if(invsd[j] == 0) return;
+
+        std::vector< std::pair<double, int> > partners; // (-|r_ij|, i), so that the usual ordering puts the largest first
+        const double* cj = cors.colptr(j);
+        for(int i = 0; i < pp; ++i){
+            if(i == j || invsd[i] == 0) continue;
+
+            double r = fabs(cj[i]) * invsd[i] * invsd[j];
+            if(r > threshold) partners.push_back(std::make_pair(-r, i));
+        }
+
+        if(k > 0 && partners.size() > static_cast<size_t>(k)){
+            std::nth_element(partners.begin(), partners.begin() + k, partners.end());
+            partners.resize(k);
+        }
+
+        nbhd[j].reserve(partners.size());
+        for(size_t m = 0; m < partners.size(); ++m) nbhd[j].push_back(partners[m].second);
+        std::sort(nbhd[j].begin(), nbhd[j].end());
+    });
+
+    return nbhd;
+}
+
+//
+// symmetrizeNeighbourhoods
+//
+//   Symmetrizes the neighbourhoods (each sorted in increasing order; SCREEN_AND: i ~ j if each was picked for the
+//     other; SCREEN_OR: if either was) and lists the candidate pairs grouped by column, with the columns in the
+//     given order (all nodes in increasing order if order is empty)
+//
+//   Output: Flat (row, col, row, col, ...) array, 0-based, as taken by BlockList
+//
+std::vector<int> symmetrizeNeighbourhoods(std::vector< std::vector<int> > nbhd, screenRule rule, const std::vector<int>& order){
+    int pp = static_cast<int>(nbhd.size());
+
+    std::vector< std::vector<int> > adj(pp);
+    for(int j = 0; j < pp; ++j){
+        for(size_t k = 0; k < nbhd[j].size(); ++k){
+            int i = nbhd[j][k];
+            bool both = std::binary_search(nbhd[i].begin(), nbhd[i].end(), j);
+
+            if(rule == SCREEN_OR){
+                adj[j].push_back(i);
+                if(!both) adj[i].push_back(j);
+            } else if(both){
+                adj[j].push_back(i);
+            }
+        }
+    }
+
+    std::vector<int> pairs;
+    for(int c = 0; c < pp; ++c){
+        int j = order.empty() ? c : order[c];
+
+        std::sort(adj[j].begin(), adj[j].end());
+        for(size_t k = 0; k < adj[j].size(); ++k){
+            pairs.push_back(adj[j][k]);
+            pairs.push_back(j);
+        }
+    }
+
+    return pairs;
+}
+
+//
+// screenPairs / marginalScreenPairs
+//
+//   The screened pairs, by neighbourhood selection or by marginal screening, in the format of
+//     symmetrizeNeighbourhoods
+//
+std::vector<int> screenPairs(const Matrix<double>& cors, double lambda, screenRule rule, unsigned int threads, const std::vector<int>& order){
+    return symmetrizeNeighbourhoods(neighbourhoodLasso(cors, lambda, threads), rule, order);
+}
+
+std::vector<int> marginalScreenPairs(const Matrix<double>& cors, int k, double threshold, screenRule rule, unsigned int threads, const std::vector<int>& order){
+    return symmetrizeNeighbourhoods(marginalNeighbourhoods(cors, k, threshold, threads), rule, order);
+}
+
+BlockList screenBlocks(const Matrix<double>& cors, double lambda, screenRule rule, unsigned int threads, const std::vector<int>& order){
+    return BlockList(screenPairs(cors, lambda, rule, threads, order), static_cast<unsigned int>(cors.ncol()));
+}
+
+BlockList marginalScreenBlocks(const Matrix<double>& cors, int k, double threshold, screenRule rule, unsigned int threads, const std::vector<int>& order){
+    return BlockList(marginalScreenPairs(cors, k, threshold, rule, threads, order), static_cast<unsigned int>(cors.ncol()));
+}
+
+//------------------------------------------------------------------------------/
+//   NODE ORDERING AND FULL BLOCK LISTS
+//------------------------------------------------------------------------------/
+
+//
+// The blocks = -2 / -3 / -4 / -6 options in R list the columns (children) in decreasing order of the largest
+//   (ORDER_BY_MAX) or total (ORDER_BY_SUM) absolute off-diagonal entry of each column of the inner products. These
+//   functions compute that order without ever forming |cors| (or any other copy of the matrix), and list every
+//   ordered pair of nodes in that order (the equivalent of allBlocks in R).
+//
+// NOTES:
+//   -the entries are used as they are (not standardized), as in R
+//   -ties are broken by node index (std::stable_sort), as by order(..., decreasing = TRUE) in R
+//
+enum nodeOrderStat {ORDER_BY_MAX, ORDER_BY_SUM};
+
+const int COLUMN_STAT_CHUNKS = 32;  // see packedColumnStats
+
+std::vector<double> columnStats(const Matrix<double>& cors, nodeOrderStat stat, unsigned int threads);
+std::vector<double> packedColumnStats(const double* cors, int pp, nodeOrderStat stat, unsigned int threads);
+std::vector<int> nodeOrder(const std::vector<double>& colstats);
+void fillAllPairs(const std::vector<int>& nodes, int* rows, int* cols, size_t stride, unsigned int threads);
+BlockList allBlocks(const std::vector<int>& nodes, unsigned int pp, unsigned int threads);
+
+//
+// columnStats
+//
+//   The largest / total absolute off-diagonal entry of each column of the full matrix, one column per task
+//
+std::vector<double> columnStats(const Matrix<double>& cors, nodeOrderStat stat, unsigned int threads){
+    int pp = static_cast<int>(cors.ncol());
+
+    std::vector<double> out(pp, 0);
+    forEachNode(pp, threads, [&](int j){
+        const double* cj = cors.colptr(j);
+        double acc = 0;
+        for(int i = 0; i < pp; ++i){
+            if(i == j) continue;
+            acc = (stat == ORDER_BY_MAX) ? std::max(acc, fabs(cj[i])) : acc + fabs(cj[i]);
+        }
+        out[j] = acc;
+    });
+
+    return out;
+}
+
+//
+// packedColumnStats
+//
+//   Same as columnStats, in one pass over the packed upper triangle (as taken by cor_vector_to_Matrix): entry (i, j)
+//     counts towards both column i and column j. The packed columns are split into COLUMN_STAT_CHUNKS contiguous
+//     chunks (with about the same number of entries in each), and each chunk accumulates into its own vector, so
+//     that no two threads ever write to the same place. The chunks are added up in order at the end.
+//
+//   NOTES:
+//     -the number of chunks is fixed, rather than one per thread, so that the sums are added up in the same order
+//       (and the result is bit-identical) whatever the number of threads
+//
+std::vector<double> packedColumnStats(const double* cors, int pp, nodeOrderStat stat, unsigned int threads){
+    int nchunks = std::max(1, std::min(COLUMN_STAT_CHUNKS, pp));
+
+    // column j of the packed triangle holds j + 1 entries, so chunk c starts at the column where
+    //   c / nchunks of the entries have been used up
+    std::vector<int> start(nchunks + 1, pp);
+    double total = 0.5 * pp * (pp + 1.0);
+    for(int c = 0; c < nchunks; ++c){
+        start[c] = static_cast<int>(ceil(0.5 * (sqrt(1.0 + 8.0 * total * c / nchunks) - 1.0)));
+        start[c] = std::min(std::max(start[c], (c > 0) ? start[c - 1] : 0), pp);
+    }
+
+    std::vector< std::vector<double> > acc(nchunks, std::vector<double>(pp, 0));
+    forEachNode(nchunks, threads, [&](int c){
+        std::vector<double>& a = acc[c];
+        for(int j = start[c]; j < start[c + 1]; ++j){
+            const double* cj = cors + static_cast<size_t>(j) * (j + 1) / 2;
+            for(int i = 0; i < j; ++i){
+                double x = fabs(cj[i]);
+                if(stat == ORDER_BY_MAX){
+                    a[i] = std::max(a[i], x);
+                    a[j] = std::max(a[j], x);
+                } else{
+                    a[i] += x;
+                    a[j] += x;
+                }
+            }
+        }
+    });
+
+    std::vector<double> out = acc[0];
+    for(int c = 1; c < nchunks; ++c){
+        for(int j = 0; j < pp; ++j){
+            out[j] = (stat == ORDER_BY_MAX) ? std::max(out[j], acc[c][j]) : out[j] + acc[c][j];
+        }
+    }
+
+    return out;
+}
+
+//
+// nodeOrder
+//
+//   Nodes in decreasing order of colstats (ties in increasing order of the node index)
+//
+std::vector<int> nodeOrder(const std::vector<double>& colstats){
+    std::vector<int> order(colstats.size());
+    for(size_t j = 0; j < order.size(); ++j) order[j] = static_cast<int>(j);
+
+    std::stable_sort(order.begin(), order.end(), [&colstats](int a, int b){ return colstats[a] > colstats[b]; });
+
+    return order;
+}
+
+//
+// fillAllPairs
+//
+//   Writes every ordered pair (row, col) of distinct nodes, grouped by column in the order of nodes, with the rows of
+//     each column also in the order of nodes (exactly as allBlocks in R). Pair k goes to rows[k * stride] and
+//     cols[k * stride], so the output can be written in place either as the flat (row, col, ...) layout of BlockList
+//     (cols = rows + 1, stride = 2) or into the two columns of a matrix (stride = 1). The columns are filled in
+//     parallel, since the position of each one is known in advance.
+//
+void fillAllPairs(const std::vector<int>& nodes, int* rows, int* cols, size_t stride, unsigned int threads){
+    int n = static_cast<int>(nodes.size());
+    size_t per_col = (n > 0) ? static_cast<size_t>(n - 1) : 0;
+
+    forEachNode(n, threads, [&](int c){
+        size_t k = static_cast<size_t>(c) * per_col * stride;
+        for(int r = 0; r < n; ++r){
+            if(r == c) continue;
+            rows[k] = nodes[r];
+            cols[k] = nodes[c];
+            k += stride;
+        }
+    });
+}
+
+//
+// allBlocks
+//
+//   Every ordered pair of the given nodes, as a BlockList (see fillAllPairs)
+//
+BlockList allBlocks(const std::vector<int>& nodes, unsigned int pp, unsigned int threads){
+    size_t n = nodes.size();
+    std::vector<int> pairs(2 * n * ((n > 0) ? n - 1 : 0));
+    if(!pairs.empty()) fillAllPairs(nodes, &pairs[0], &pairs[1], 2, threads);
+
+    return BlockList(pairs, pp);
+}
+
+#endif
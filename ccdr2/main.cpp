@@ -31,8 +31,10 @@ int main(int argc, const char * argv[]){
         FILE_LOG(logINFO) << "Log file opened.";
     #endif
     
-    // set seed for rand()
-    srand(static_cast<unsigned int>(time(NULL)));
+    // set a fixed seed for rand() so that runs can be repeated exactly: rand() is only used here to generate test
+    //   data, the random block orders (randomize = true) are seeded through params[12] (see singleCCDr)
+    const unsigned int SEED = 1;
+    srand(SEED);
     
     if(GENERATE_NEW){
         //
@@ -117,11 +119,13 @@ int main(int argc, const char * argv[]){
     //
     SparseMatrix b0 = SparseMatrix(pp_fixed);
 
-    std::vector<std::vector<int>> bl;
+    std::vector<int> bl;
+    bl.reserve(2 * pp_fixed * (pp_fixed - 1));
     for(int j = 0; j < pp_fixed; ++j){
         for(int i = 0; i < pp_fixed; ++i){
             if(i != j){
-                bl.push_back({i, j});
+                bl.push_back(i);
+                bl.push_back(j);
             }
         }
     }
@@ -139,7 +143,7 @@ int main(int argc, const char * argv[]){
     clock_t t = clock();
     std::vector<SparseMatrix> grid_ccdr;
     grid_ccdr = gridCCDr(c,
-        b0,
+        std::move(b0),
         s0, // initial value for sigmas
         nn_fixed,
         lambdas,
@@ -5,12 +5,26 @@
 
 #include <vector>
 #include <iomanip>
-
+#include <stdexcept>
+
+//
+// Dense, column-major matrix
+//
+// A Matrix either owns its data, or is a read-only view of column-major data owned by someone else (e.g. an R
+//   matrix), in which case nothing is copied. Writing through a view (the non-const operator()) throws
+//   std::logic_error, since the viewed data is not ours to modify.
+//
 template <class T>
 class Matrix{
 public:
     Matrix(size_t rows, size_t cols);
     Matrix(T fill, size_t rows, size_t cols);
+    Matrix(const T* data, size_t rows, size_t cols);    // view: data must outlive the Matrix (and its copies)
+    Matrix(const Matrix& other);
+    Matrix(Matrix&& other);
+    Matrix& operator=(const Matrix& other);
+    Matrix& operator=(Matrix&& other);
+
     T& operator()(size_t i, size_t j);
     T operator()(size_t i, size_t j) const;
     size_t nrow() const;
@@ -18,19 +32,25 @@ public:
 
     std::vector<T> vprod(std::vector<T> x) const;
     std::vector<T> col(size_t j) const;
+    const T* colptr(size_t j) const;
+    bool isView() const;
     void print() const;
 
 private:
     size_t mRows;
     size_t mCols;
-    std::vector<T> mData;
+    std::vector<T> mData;   // empty for views
+    const T* mPtr;          // mData.data(), or the viewed data
+    bool mView;
 };
 
 template <class T>
 Matrix<T>::Matrix(size_t rows, size_t cols)
 : mRows(rows),
   mCols(cols),
-  mData(rows * cols)
+  mData(rows * cols),
+  mPtr(mData.data()),
+  mView(false)
 {
 }
 
@@ -38,31 +58,94 @@ template <class T>
 Matrix<T>::Matrix(T fill, size_t rows, size_t cols)
 : mRows(rows),
   mCols(cols),
-  mData(rows * cols)
+  mData(rows * cols),
+  mPtr(mData.data()),
+  mView(false)
 {
     std::fill(mData.begin(), mData.end(), fill);
 }
 
+template <class T>
+Matrix<T>::Matrix(const T* data, size_t rows, size_t cols)
+: mRows(rows),
+  mCols(cols),
+  mPtr(data),
+  mView(true)
+{
+}
+
+// copying a view copies the view, not the data
+template <class T>
+Matrix<T>::Matrix(const Matrix& other)
+: mRows(other.mRows),
+  mCols(other.mCols),
+  mData(other.mData),
+  mPtr(other.mView ? other.mPtr : mData.data()),
+  mView(other.mView)
+{
+}
+
+template <class T>
+Matrix<T>::Matrix(Matrix&& other)
+: mRows(other.mRows),
+  mCols(other.mCols),
+  mData(std::move(other.mData)),
+  mPtr(other.mView ? other.mPtr : mData.data()),
+  mView(other.mView)
+{
+}
+
+template <class T>
+Matrix<T>& Matrix<T>::operator=(const Matrix& other){
+    mRows = other.mRows;
+    mCols = other.mCols;
+    mData = other.mData;
+    mView = other.mView;
+    mPtr = mView ? other.mPtr : mData.data();
+
+    return *this;
+}
+
+template <class T>
+Matrix<T>& Matrix<T>::operator=(Matrix&& other){
+    mRows = other.mRows;
+    mCols = other.mCols;
+    mData = std::move(other.mData);
+    mView = other.mView;
+    mPtr = mView ? other.mPtr : mData.data();
+
+    return *this;
+}
+
 template <class T>
 T& Matrix<T>::operator()(size_t i, size_t j){
+    if(mView) throw std::logic_error("Matrix: cannot write to a read-only view");
     return mData[j * mRows + i];
 }
 
 template <class T>
 T Matrix<T>::operator()(size_t i, size_t j) const{
-    return mData[j * mRows + i];
+    return mPtr[j * mRows + i];
 }
 
 template <class T>
 std::vector<T> Matrix<T>::col(size_t j) const{
-    typedef typename std::vector<T>::const_iterator const_iterator;
-    const_iterator first = mData.begin() + j * mRows;
-    const_iterator last = mData.begin() + (j+1) * mRows;
-    std::vector<T> colj(first, last);
-    
+    std::vector<T> colj(mPtr + j * mRows, mPtr + (j+1) * mRows);
+
     return colj;
 }
 
+// pointer to the (contiguous) jth column, for kernels that need raw access
+template <class T>
+const T* Matrix<T>::colptr(size_t j) const{
+    return mPtr + j * mRows;
+}
+
+template <class T>
+bool Matrix<T>::isView() const{
+    return mView;
+}
+
 template <class T>
 size_t Matrix<T>::nrow() const{
     return mRows;
@@ -32,7 +32,7 @@ T vnorm(std::vector<T> x){
 }
 
 template <class T>
-T matinnerprod(Matrix<T> x, size_t col1, size_t col2){
+T matinnerprod(const Matrix<T>& x, size_t col1, size_t col2){
     T ip = 0;
     for(auto i = 0; i < x.nrow(); ++i){
         ip += x(i, col1) * x(i, col2);
@@ -42,7 +42,7 @@ T matinnerprod(Matrix<T> x, size_t col1, size_t col2){
 }
 
 template <class T>
-Matrix<T> gram(Matrix<T> x){
+Matrix<T> gram(const Matrix<T>& x){
     Matrix<T> grammat(x.ncol(), x.ncol());
     for(size_t i = 0; i < x.ncol(); ++i){
         for(size_t j = 0; j < x.ncol(); ++j){